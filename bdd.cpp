@@ -0,0 +1,266 @@
+/**
+ * @file bdd.cpp
+ * @brief The recursive operations and memory management of BddManager.
+ */
+
+#include <algorithm>
+#include <cmath>
+
+#include "bdd.h"
+
+using std::vector;
+
+BddManager::BddManager(){
+	epoch = 0;
+	collected = 0;
+	clear(0);
+}
+
+void BddManager::clear(unsigned int variables){
+	count = variables < MAX_VARIABLES ? variables : MAX_VARIABLES;
+	nodes.clear();
+	Node terminal = {TERMINAL, 0, 0, 0};
+	nodes.push_back(terminal);
+	terminal.low = terminal.high = 1;
+	nodes.push_back(terminal);
+	live = 2;
+	freeList = 0;
+	buckets.assign(INITIAL_BUCKETS, 0);
+	if(cache.size() < INITIAL_BUCKETS){
+		CacheEntry empty = {};
+		cache.assign(INITIAL_BUCKETS, empty);
+	}
+	flushCache();
+}
+
+BddRef BddManager::make(unsigned int var, BddRef low, BddRef high){
+	if(low == high)
+		return low;
+	std::size_t b = bucket(var, low, high);
+	for(BddRef i = buckets[b]; i != 0; i = nodes[i].next){
+		if(nodes[i].var == var and nodes[i].low == low and nodes[i].high == high)
+			return i;
+	}
+	BddRef rval;
+	Node node = {var, low, high, buckets[b]};
+	if(freeList != 0){
+		rval = freeList;
+		freeList = nodes[rval].next;
+		nodes[rval] = node;
+	}else{
+		rval = (BddRef)nodes.size();
+		nodes.push_back(node);
+	}
+	buckets[b] = rval;
+	if(++live > buckets.size())
+		grow();
+	return rval;
+}
+
+void BddManager::grow(){
+	buckets.assign(buckets.size() * 2, 0);
+	rehash();
+	if(cache.size() < buckets.size() and cache.size() < MAX_CACHE){
+		CacheEntry empty = {};
+		cache.assign(cache.size() * 2, empty);
+	}
+}
+
+void BddManager::rehash(){
+	std::fill(buckets.begin(), buckets.end(), 0);
+	for(BddRef i = 2; i < nodes.size(); ++i){
+		if(nodes[i].var == FREE)
+			continue;
+		std::size_t b = bucket(nodes[i].var, nodes[i].low, nodes[i].high);
+		nodes[i].next = buckets[b];
+		buckets[b] = i;
+	}
+}
+
+void BddManager::flushCache(){
+	if(++epoch == 0){
+		//the stamps have wrapped, old entries could look current again
+		CacheEntry empty = {};
+		std::fill(cache.begin(), cache.end(), empty);
+		epoch = 1;
+	}
+}
+
+BddRef BddManager::cube(std::uint64_t mask){
+	BddRef rval = BDD_TRUE;
+	for(unsigned int v = count; v-- > 0;){
+		if(mask >> v & 1)
+			rval = make(v, BDD_FALSE, rval);
+	}
+	return rval;
+}
+
+BddRef BddManager::ite(BddRef f, BddRef g, BddRef h){
+	if(f == BDD_TRUE)
+		return g;
+	if(f == BDD_FALSE)
+		return h;
+	if(g == h)
+		return g;
+	if(g == BDD_TRUE and h == BDD_FALSE)
+		return f;
+	BddRef rval;
+	if(lookup(OP_ITE, f, g, h, rval))
+		return rval;
+	unsigned int top = std::min(level(f), std::min(level(g), level(h)));
+	//cofactors with respect to the top variable, copied since make() may move the nodes
+	BddRef f0 = level(f) == top ? nodes[f].low : f, f1 = level(f) == top ? nodes[f].high : f;
+	BddRef g0 = level(g) == top ? nodes[g].low : g, g1 = level(g) == top ? nodes[g].high : g;
+	BddRef h0 = level(h) == top ? nodes[h].low : h, h1 = level(h) == top ? nodes[h].high : h;
+	BddRef low = ite(f0, g0, h0);
+	BddRef high = ite(f1, g1, h1);
+	rval = make(top, low, high);
+	store(OP_ITE, f, g, h, rval);
+	return rval;
+}
+
+BddRef BddManager::exists(BddRef f, BddRef cube){
+	while(level(cube) < level(f))
+		cube = nodes[cube].high;
+	if(f <= BDD_TRUE or cube == BDD_TRUE)
+		return f;
+	BddRef rval;
+	if(lookup(OP_EXISTS, f, cube, 0, rval))
+		return rval;
+	unsigned int var = level(f);
+	BddRef f0 = nodes[f].low, f1 = nodes[f].high;
+	if(level(cube) == var){
+		BddRef rest = nodes[cube].high;
+		rval = exists(f0, rest);
+		if(rval != BDD_TRUE)
+			rval = disjoin(rval, exists(f1, rest));
+	}else{
+		BddRef low = exists(f0, cube);
+		BddRef high = exists(f1, cube);
+		rval = make(var, low, high);
+	}
+	store(OP_EXISTS, f, cube, 0, rval);
+	return rval;
+}
+
+BddRef BddManager::andExists(BddRef f, BddRef g, BddRef cube){
+	if(f == BDD_FALSE or g == BDD_FALSE)
+		return BDD_FALSE;
+	if(f == BDD_TRUE)
+		return exists(g, cube);
+	if(g == BDD_TRUE or f == g)
+		return exists(f, cube);
+	if(cube == BDD_TRUE)
+		return conjoin(f, g);
+	if(g < f)
+		std::swap(f, g);
+	unsigned int top = std::min(level(f), level(g));
+	while(level(cube) < top)
+		cube = nodes[cube].high;
+	BddRef rval;
+	if(lookup(OP_AND_EXISTS, f, g, cube, rval))
+		return rval;
+	BddRef f0 = level(f) == top ? nodes[f].low : f, f1 = level(f) == top ? nodes[f].high : f;
+	BddRef g0 = level(g) == top ? nodes[g].low : g, g1 = level(g) == top ? nodes[g].high : g;
+	if(level(cube) == top){
+		BddRef rest = nodes[cube].high;
+		rval = andExists(f0, g0, rest);
+		if(rval != BDD_TRUE)
+			rval = disjoin(rval, andExists(f1, g1, rest));
+	}else{
+		BddRef low = andExists(f0, g0, cube);
+		BddRef high = andExists(f1, g1, cube);
+		rval = make(top, low, high);
+	}
+	store(OP_AND_EXISTS, f, g, cube, rval);
+	return rval;
+}
+
+BddRef BddManager::shift(BddRef f, int offset){
+	if(f <= BDD_TRUE or offset == 0)
+		return f;
+	BddRef rval;
+	if(lookup(OP_SHIFT, f, (BddRef)offset, 0, rval))
+		return rval;
+	unsigned int var = level(f);
+	BddRef f0 = nodes[f].low, f1 = nodes[f].high;
+	BddRef low = shift(f0, offset);
+	BddRef high = shift(f1, offset);
+	rval = make((unsigned int)(var + offset), low, high);
+	store(OP_SHIFT, f, (BddRef)offset, 0, rval);
+	return rval;
+}
+
+bool BddManager::evaluate(BddRef f, std::uint64_t assignment)const{
+	while(f > BDD_TRUE)
+		f = (assignment >> nodes[f].var & 1) ? nodes[f].high : nodes[f].low;
+	return f == BDD_TRUE;
+}
+
+bool BddManager::pick(BddRef f, std::uint64_t &assignment)const{
+	assignment = 0;
+	if(f == BDD_FALSE)
+		return false;
+	//a reduced BDD reaches true from every node but the false one
+	while(f != BDD_TRUE){
+		if(nodes[f].low != BDD_FALSE){
+			f = nodes[f].low;
+		}else{
+			assignment |= (std::uint64_t)1 << nodes[f].var;
+			f = nodes[f].high;
+		}
+	}
+	return true;
+}
+
+double BddManager::satCount(BddRef f, unsigned int over)const{
+	//the fraction of all assignments satisfying each node, which needs no levels
+	vector <double> fraction(nodes.size(), -1);
+	fraction[BDD_FALSE] = 0;
+	fraction[BDD_TRUE] = 1;
+	vector <BddRef> stack(1, f);
+	while(!stack.empty()){
+		BddRef n = stack.back();
+		if(fraction[n] >= 0){
+			stack.pop_back();
+			continue;
+		}
+		BddRef low = nodes[n].low, high = nodes[n].high;
+		if(fraction[low] < 0){
+			stack.push_back(low);
+		}else if(fraction[high] < 0){
+			stack.push_back(high);
+		}else{
+			fraction[n] = (fraction[low] + fraction[high]) / 2;
+			stack.pop_back();
+		}
+	}
+	return std::ldexp(fraction[f], (int)over);
+}
+
+void BddManager::collect(const vector <BddRef> &roots){
+	vector <bool> marked(nodes.size(), false);
+	marked[BDD_FALSE] = marked[BDD_TRUE] = true;
+	vector <BddRef> stack(roots.begin(), roots.end());
+	while(!stack.empty()){
+		BddRef n = stack.back();
+		stack.pop_back();
+		if(marked[n])
+			continue;
+		marked[n] = true;
+		stack.push_back(nodes[n].low);
+		stack.push_back(nodes[n].high);
+	}
+	for(BddRef i = 2; i < nodes.size(); ++i){
+		if(marked[i] or nodes[i].var == FREE)
+			continue;
+		nodes[i].var = FREE;
+		nodes[i].next = freeList;
+		freeList = i;
+		--live;
+	}
+	rehash();
+	//cached results may name reclaimed nodes
+	flushCache();
+	++collected;
+}
@@ -0,0 +1,191 @@
+/**
+ * @file bdd.h
+ * @brief A small reduced ordered binary decision diagram package.
+ *
+ * A BDD stands for a boolean function of numbered variables, tested in
+ * increasing order along every path. Nodes are hash consed in a unique table, so
+ * equal functions are the same BddRef and comparing two sets of states is an
+ * integer compare. Results of the recursive operations are kept in a computed
+ * cache stamped with an epoch like StateTable's slots, and nodes nobody refers
+ * to any more are reclaimed by collect(), given the functions still in use.
+ */
+
+#ifndef FWDC_BDD_H
+#define FWDC_BDD_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+///@brief A node of a BddManager, and the function rooted at it
+typedef std::uint32_t BddRef;
+
+static const BddRef BDD_FALSE = 0;///<the constant false function
+static const BddRef BDD_TRUE = 1;///<the constant true function
+
+/**
+ * @brief Owner of the nodes of a set of BDDs over the same variables
+ *
+ * A BddRef stays valid until clear(), or collect() if it wasn't one of the roots.
+ */
+class BddManager{
+public:
+	static const unsigned int MAX_VARIABLES = 64;///<assignments are packed into 64 bits
+
+	BddManager();
+
+	///@brief Drop every node and start again over a number of variables
+	void clear(unsigned int variables);
+
+	unsigned int variables()const{
+		return count;
+	}
+
+	///@brief Nodes in use, the two constants included
+	std::size_t size()const{
+		return live;
+	}
+
+	///@brief The function that is true when variable v is
+	BddRef variable(unsigned int v){
+		return make(v, BDD_FALSE, BDD_TRUE);
+	}
+
+	///@brief If f then g else h, every other operation is built from this one
+	BddRef ite(BddRef f, BddRef g, BddRef h);
+
+	BddRef negate(BddRef f){
+		return ite(f, BDD_FALSE, BDD_TRUE);
+	}
+
+	BddRef conjoin(BddRef f, BddRef g){
+		return ite(f, g, BDD_FALSE);
+	}
+
+	BddRef disjoin(BddRef f, BddRef g){
+		return ite(f, BDD_TRUE, g);
+	}
+
+	///@brief The function that is true where f and g agree
+	BddRef equal(BddRef f, BddRef g){
+		return ite(f, g, negate(g));
+	}
+
+	///@brief Conjunction of the variables set in a mask, the form exists() takes them in
+	BddRef cube(std::uint64_t mask);
+
+	///@brief Existentially quantify the variables of a cube out of f
+	BddRef exists(BddRef f, BddRef cube);
+
+	///@brief exists(conjoin(f, g), cube) without building the conjunction, the image of a set under a relation
+	BddRef andExists(BddRef f, BddRef g, BddRef cube);
+
+	///@brief Rename every variable v of f to v + offset
+	///@note The renaming has to keep the variables of f in the same order.
+	BddRef shift(BddRef f, int offset);
+
+	///@brief Value of f for an assignment, bit v giving variable v
+	bool evaluate(BddRef f, std::uint64_t assignment)const;
+
+	///@brief Find an assignment satisfying f, leaving the variables it doesn't test clear
+	///@return False if f is BDD_FALSE
+	bool pick(BddRef f, std::uint64_t &assignment)const;
+
+	///@brief Number of assignments satisfying f of the first over variables
+	///@note f must not depend on any other variable.
+	double satCount(BddRef f, unsigned int over)const;
+
+	///@brief Reclaim every node not reachable from the roots
+	void collect(const std::vector <BddRef> &roots);
+
+	///@brief Times collect() has run since the manager was made
+	unsigned long collections()const{
+		return collected;
+	}
+
+private:
+	static const unsigned int TERMINAL = MAX_VARIABLES;///<variable of the two constants, ordered after every real one
+	static const unsigned int FREE = 0xffffffff;///<variable of a node on the free list
+	static const std::size_t INITIAL_BUCKETS = 1 << 10;
+	static const std::size_t MAX_CACHE = 1 << 22;
+
+	///@brief Operations kept in the computed cache
+	enum Operation{
+		OP_ITE = 1,
+		OP_EXISTS,
+		OP_AND_EXISTS,
+		OP_SHIFT
+	};
+
+	struct Node{
+		unsigned int var;///<variable tested, TERMINAL for the constants and FREE for reclaimed nodes
+		BddRef low;///<function when the variable is false
+		BddRef high;///<function when the variable is true
+		BddRef next;///<next node in the same unique table bucket or on the free list, 0 for none
+	};
+
+	struct CacheEntry{
+		unsigned int epoch;///<the entry is empty unless this is the manager's epoch
+		unsigned int op;
+		BddRef f, g, h;
+		BddRef result;
+	};
+
+	std::vector <Node> nodes;
+	std::vector <BddRef> buckets;///<unique table, the first node of each chain
+	std::vector <CacheEntry> cache;
+	BddRef freeList;///<first reclaimed node, 0 if there is none
+	std::size_t live;
+	unsigned int count;
+	unsigned int epoch;
+	unsigned long collected;
+
+	BddManager(const BddManager &);
+	BddManager &operator=(const BddManager &);
+
+	unsigned int level(BddRef f)const{
+		return nodes[f].var;
+	}
+
+	///@brief The node testing var with the given branches, made if it isn't in the unique table
+	BddRef make(unsigned int var, BddRef low, BddRef high);
+
+	std::size_t bucket(unsigned int var, BddRef low, BddRef high)const{
+		std::uint64_t h = ((std::uint64_t)var << 58) ^ ((std::uint64_t)low << 29) ^ high;
+		return (std::size_t)((h * 0x9E3779B97F4A7C15ull) >> 32) & (buckets.size() - 1);
+	}
+
+	///@brief Double the unique table and, up to MAX_CACHE, the computed cache
+	void grow();
+
+	///@brief Rebuild the unique table from the nodes in use
+	void rehash();
+
+	///@brief Forget every cached result
+	void flushCache();
+
+	CacheEntry &entry(unsigned int op, BddRef f, BddRef g, BddRef h){
+		std::uint64_t k = ((std::uint64_t)op << 60) ^ ((std::uint64_t)f << 40) ^ ((std::uint64_t)g << 20) ^ h;
+		return cache[(std::size_t)((k * 0xD6E8FEB86659FD93ull) >> 32) & (cache.size() - 1)];
+	}
+
+	bool lookup(unsigned int op, BddRef f, BddRef g, BddRef h, BddRef &result){
+		const CacheEntry &e = entry(op, f, g, h);
+		if(e.epoch != epoch or e.op != op or e.f != f or e.g != g or e.h != h)
+			return false;
+		result = e.result;
+		return true;
+	}
+
+	void store(unsigned int op, BddRef f, BddRef g, BddRef h, BddRef result){
+		CacheEntry &e = entry(op, f, g, h);
+		e.epoch = epoch;
+		e.op = op;
+		e.f = f;
+		e.g = g;
+		e.h = h;
+		e.result = result;
+	}
+};
+
+#endif
@@ -0,0 +1,211 @@
+/**
+ * @file bench.cpp
+ * @brief Benchmark suite for the solver, also the training run for profile guided builds.
+ *
+ * Every configuration solves the same batch of queries on one SolverContext, so
+ * the numbers include the reuse of tables and frontiers between queries the way
+ * a long running service sees it.
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "solver.h"
+
+using std::string;
+using std::vector;
+using std::cout;
+using std::endl;
+
+#ifndef FWDC_PUZZLE_DIR
+#define FWDC_PUZZLE_DIR "puzzles"
+#endif
+
+///@brief A puzzle and the queries solved on it
+struct Workload{
+	string name;
+	Puzzle puzzle;
+	vector <State> starts;///<each is solved towards the puzzle's default goal
+	unsigned int passes;///<times the queries are solved per --repeat, so each workload takes a similar time
+	bool small;///<cheap enough for IDA*, which keeps no table of visited states
+};
+
+///@brief One way of running the searches
+struct Configuration{
+	const char * name;
+	Algorithm algorithm;
+	FrontierKind frontier;
+	bool filter;///<see SearchOptions::filter
+	HugePages hugePages;///<see SearchOptions::hugePages
+	unsigned int heuristics;///<bits 1 << Heuristic of those used along with counting, see SearchOptions::heuristics
+};
+
+static const unsigned int EVERY_HEURISTIC = 1 << HEURISTIC_CROSSINGS | 1 << HEURISTIC_PATTERN | 1 << HEURISTIC_LANDMARKS;
+
+static const Configuration configurations[] = {
+	{"astar/multimap", ALGORITHM_ASTAR, FRONTIER_MULTIMAP, false, HUGE_PAGES_OFF, 0},
+	{"astar/heap", ALGORITHM_ASTAR, FRONTIER_HEAP, false, HUGE_PAGES_OFF, 0},
+	{"astar/heap+filter", ALGORITHM_ASTAR, FRONTIER_HEAP, true, HUGE_PAGES_OFF, 0},
+	{"astar/heap+huge", ALGORITHM_ASTAR, FRONTIER_HEAP, false, HUGE_PAGES_TRANSPARENT, 0},
+	{"astar/bucket", ALGORITHM_ASTAR, FRONTIER_BUCKET, false, HUGE_PAGES_OFF, 0},
+	{"astar/heap+all-h", ALGORITHM_ASTAR, FRONTIER_HEAP, false, HUGE_PAGES_OFF, EVERY_HEURISTIC},
+	{"astar/heap+alt", ALGORITHM_ASTAR, FRONTIER_HEAP, false, HUGE_PAGES_OFF, 1 << HEURISTIC_LANDMARKS},
+	{"astar/heap+learned", ALGORITHM_ASTAR, FRONTIER_HEAP, false, HUGE_PAGES_OFF, 1 << HEURISTIC_LEARNED},
+	{"lazy/heap", ALGORITHM_LAZY, FRONTIER_HEAP, false, HUGE_PAGES_OFF, EVERY_HEURISTIC},
+	{"weighted/heap", ALGORITHM_WEIGHTED, FRONTIER_HEAP, false, HUGE_PAGES_OFF, 0},
+	{"epea/heap", ALGORITHM_EPEA, FRONTIER_HEAP, false, HUGE_PAGES_OFF, 0},
+	{"epea/bucket", ALGORITHM_EPEA, FRONTIER_BUCKET, false, HUGE_PAGES_OFF, 0},
+	{"ida", ALGORITHM_IDA, FRONTIER_HEAP, false, HUGE_PAGES_OFF, 0},
+	{"bfs", ALGORITHM_BFS, FRONTIER_HEAP, false, HUGE_PAGES_OFF, 0},
+	{"bfs+filter", ALGORITHM_BFS, FRONTIER_HEAP, true, HUGE_PAGES_OFF, 0},
+	{"bfs+huge", ALGORITHM_BFS, FRONTIER_HEAP, false, HUGE_PAGES_TRANSPARENT, 0},
+	{"bfs+hugetlb", ALGORITHM_BFS, FRONTIER_HEAP, false, HUGE_PAGES_EXPLICIT, 0},
+	{"bidirectional", ALGORITHM_BIDIRECTIONAL, FRONTIER_HEAP, false, HUGE_PAGES_OFF, 0},
+	{"bidirectional+filter", ALGORITHM_BIDIRECTIONAL, FRONTIER_HEAP, true, HUGE_PAGES_OFF, 0},
+	{"parallel", ALGORITHM_PARALLEL, FRONTIER_HEAP, false, HUGE_PAGES_OFF, 0},
+	{"bitmap", ALGORITHM_BITMAP, FRONTIER_HEAP, false, HUGE_PAGES_OFF, 0},
+	{"bdd", ALGORITHM_BDD, FRONTIER_HEAP, false, HUGE_PAGES_OFF, 0},
+	{"paths", ALGORITHM_PATHS, FRONTIER_HEAP, false, HUGE_PAGES_OFF, 0},
+	{"hierarchy", ALGORITHM_HIERARCHY, FRONTIER_HEAP, false, HUGE_PAGES_OFF, 0},
+	{"realtime", ALGORITHM_REALTIME, FRONTIER_HEAP, false, HUGE_PAGES_OFF, 0},
+};
+
+///@brief Pick up to count legal states of a puzzle with a fixed pseudo random sequence
+static vector <State> sampleStarts(const Puzzle &puzzle, unsigned int count){
+	vector <State> rval;
+	rval.push_back(puzzle.start);
+	unsigned long long seed = 0x2545F4914F6CDD1Dull;
+	for(unsigned int tries = 0; rval.size() < count and tries < 64 * count; ++tries){
+		seed ^= seed << 13;
+		seed ^= seed >> 7;
+		seed ^= seed << 17;
+		State s = (State)seed & puzzle.all();
+		if(puzzle.legal(s))
+			rval.push_back(s);
+	}
+	return rval;
+}
+
+///@brief Load a puzzle file from the puzzle directory, or exit
+static Workload load(const string &name, unsigned int queries, unsigned int passes, bool small){
+	Workload rval;
+	string error;
+	rval.name = name;
+	rval.passes = passes;
+	rval.small = small;
+	if(!rval.puzzle.loadFile(string(FWDC_PUZZLE_DIR) + "/" + name + ".txt", error)){
+		std::cerr << "fwdc_bench: " << error << endl;
+		std::exit(1);
+	}
+	rval.starts = sampleStarts(rval.puzzle, queries);
+	return rval;
+}
+
+int main(int argc, char ** argv){
+	bool quick = false;
+	unsigned int repeat = 0;
+	string only;
+	for(int i = 1; i < argc; ++i){
+		string arg = argv[i];
+		if(arg == "--quick"){
+			quick = true;
+		}else if(arg == "--repeat" and i + 1 < argc){
+			repeat = (unsigned int)std::atoi(argv[++i]);
+		}else if(arg == "--only" and i + 1 < argc){
+			only = argv[++i];
+		}else{
+			std::cerr << "usage: fwdc_bench [--quick] [--repeat N] [--only CONFIGURATION]" << endl;
+			return 2;
+		}
+	}
+	if(repeat == 0)
+		repeat = 1;
+
+	vector <Workload> workloads;
+	Workload classic;
+	classic.name = "fwdc";
+	classic.passes = quick ? 1 : 1000;
+	classic.small = true;
+	for(State s = 0; s <= classic.puzzle.all(); ++s){
+		if(classic.puzzle.legal(s))
+			classic.starts.push_back(s);
+	}
+	workloads.push_back(classic);
+	workloads.push_back(load("menagerie", 64, quick ? 1 : 20, true));
+	workloads.push_back(load("barnyard", quick ? 4 : 16, 1, false));
+	if(!quick)
+		workloads.push_back(load("ark", 2, 1, false));
+
+	unsigned int threads = std::max(2u, std::thread::hardware_concurrency());
+	std::printf("%-10s %-20s %8s %12s %10s %12s %8s %9s %8s %8s\n", "puzzle", "configuration", "queries", "expanded", "ms", "us/solve", "Mexp/s",
+			"filtered", "fp-rate", "h-saved");
+	for(unsigned int w = 0; w < workloads.size(); ++w){
+		const Workload &workload = workloads[w];
+		Goal goal(workload.puzzle.goal, workload.puzzle.all());
+		for(unsigned int c = 0; c < sizeof(configurations) / sizeof(configurations[0]); ++c){
+			const Configuration &configuration = configurations[c];
+			if(!only.empty() and only != configuration.name)
+				continue;
+			//IDA* keeps no table, the path database and hierarchy take long to build for the large puzzles
+			if((configuration.algorithm == ALGORITHM_IDA or configuration.algorithm == ALGORITHM_PATHS
+					or configuration.algorithm == ALGORITHM_HIERARCHY) and !workload.small)
+				continue;
+			SolverContext solver;
+			solver.options.algorithm = configuration.algorithm;
+			solver.options.frontier = configuration.frontier;
+			solver.options.threads = threads;
+			solver.options.filter = configuration.filter;
+			solver.options.hugePages = configuration.hugePages;
+			for(unsigned int h = HEURISTIC_CROSSINGS; h <= HEURISTIC_LEARNED; ++h){
+				if(configuration.heuristics & 1 << h)
+					solver.options.heuristics.push_back((Heuristic)h);
+			}
+			SearchResult result;
+			unsigned long long expanded = 0, evaluations = 0, saved = 0;
+			LookupStats lookups;
+			std::chrono::steady_clock::time_point begin = std::chrono::steady_clock::now();
+			for(unsigned int r = 0; r < repeat * workload.passes; ++r){
+				for(unsigned int q = 0; q < workload.starts.size(); ++q){
+					solver.solve(workload.puzzle, workload.starts[q], goal, result);
+					expanded += result.expanded;
+					evaluations += result.evaluations;
+					saved += result.evaluationsSaved;
+					lookups.add(result.lookups);
+				}
+			}
+			double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - begin).count();
+			unsigned long solves = (unsigned long)repeat * workload.passes * workload.starts.size();
+			std::printf("%-10s %-20s %8lu %12llu %10.2f %12.2f %8.2f", workload.name.c_str(), configuration.name,
+					solves, expanded, ms, 1000 * ms / solves, expanded / ms / 1000);
+			//share of the duplicate checks the filter answered alone, and how often it wrongly passed one on
+			if(configuration.filter)
+				std::printf(" %8.1f%% %7.3f%%", 100.0 * lookups.filtered / std::max(lookups.lookups, 1ul), 100 * lookups.falsePositiveRate());
+			else
+				std::printf(" %9s %8s", "-", "-");
+			//heuristic evaluations lazy A* put off for good, out of those eager A* would make
+			if(configuration.algorithm == ALGORITHM_LAZY)
+				std::printf(" %7.1f%%\n", 100.0 * saved / std::max(saved + evaluations, 1ull));
+			else
+				std::printf(" %8s\n", "-");
+		}
+	}
+	//what the path databases cost against a table of the first move for every pair of states
+	for(unsigned int w = 0; w < workloads.size(); ++w){
+		PathDatabase paths;
+		if(!workloads[w].small or !paths.prepare(workloads[w].puzzle))
+			continue;
+		std::printf("path database for %s: %zu states, %zu runs, %zu bytes against %zu for every pair\n", workloads[w].name.c_str(),
+				paths.states(), paths.runCount(), paths.bytes(), 2 * paths.states() * paths.states());
+	}
+	if(hugePageFallbacks(HUGE_PAGES_EXPLICIT) or hugePageFallbacks(HUGE_PAGES_TRANSPARENT)){
+		std::printf("huge pages refused: %lu explicit mappings fell back to transparent, %lu transparent requests failed\n",
+				hugePageFallbacks(HUGE_PAGES_EXPLICIT), hugePageFallbacks(HUGE_PAGES_TRANSPARENT));
+	}
+	return 0;
+}
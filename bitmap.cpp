@@ -0,0 +1,79 @@
+/**
+ * @file bitmap.cpp
+ * @brief Whole sets of states of a puzzle as bitmaps: its legal states, one crossing of the river
+ * and layers kept without the farmer.
+ */
+
+#if defined(__BMI2__)
+#include <immintrin.h>
+#endif
+
+#include "bitmap.h"
+#include "puzzle.h"
+
+void findLegal(const Puzzle &puzzle, StateBitmap &legal){
+	unsigned int items = (unsigned int)puzzle.items.size();
+	legal.reset(items);
+	//with fewer than 6 items a single word holds every state and the rest of it
+	std::uint64_t valid = items < 6 ? ((std::uint64_t)1 << (1u << items)) - 1 : ~(std::uint64_t)0;
+	for(std::size_t w = 0; w < legal.words.size(); ++w){
+		std::uint64_t farmerLeft = bitEquals(w, 0, true);
+		std::uint64_t illegal = 0;
+		for(unsigned int i = 0; i < puzzle.conflicts.size(); ++i){
+			unsigned int a = StateBitmap::lowestBit(puzzle.conflicts[i]);
+			unsigned int b = StateBitmap::lowestBit(puzzle.conflicts[i] & ~(1u << a));
+			illegal |= bitEquals(w, a, true) & bitEquals(w, b, true) & ~farmerLeft;
+			illegal |= bitEquals(w, a, false) & bitEquals(w, b, false) & farmerLeft;
+		}
+		legal.words[w] = ~illegal & valid;
+	}
+}
+
+void crossRiver(const Puzzle &puzzle, const StateBitmap &from, StateBitmap &to, StateBitmap &scratch){
+	unsigned int items = (unsigned int)puzzle.items.size();
+	std::size_t words = from.words.size();
+	to.words.resize(words);
+	for(std::size_t w = 0; w < words; ++w)
+		to.words[w] = xorPositions(from.words[w], 1);
+	for(unsigned int passengers = 0; passengers < puzzle.capacity and passengers + 1 < items; ++passengers){
+		scratch.words = to.words;
+		for(unsigned int item = 1; item < items; ++item){
+			for(std::size_t w = 0; w < words; ++w){
+				std::uint64_t farmerLeft = bitEquals(w, 0, true);
+				//states where the item is still on the bank the farmer left
+				std::uint64_t behind = to.words[w] & (bitEquals(w, item, true) ^ farmerLeft);
+				if(behind == 0)
+					continue;
+				if(item < 6)
+					scratch.words[w] |= xorPositions(behind, 1u << item);
+				else
+					scratch.words[w ^ ((std::size_t)1 << (item - 6))] |= behind;
+			}
+		}
+		to.words.swap(scratch.words);
+	}
+}
+
+///@brief Gather the bits at even positions of a word into its low half
+static inline std::uint64_t evenBits(std::uint64_t w){
+#if defined(__BMI2__)
+	return _pext_u64(w, BIT_CLEAR_MASKS[0]);
+#else
+	w &= BIT_CLEAR_MASKS[0];
+	for(unsigned int k = 1; k < 6; ++k)
+		w = (w | w >> (1u << (k - 1))) & BIT_CLEAR_MASKS[k];
+	return w;
+#endif
+}
+
+void dropFarmer(unsigned int items, const StateBitmap &from, bool farmerLeft, StateBitmap &to){
+	std::size_t bits = (std::size_t)1 << (items - 1);
+	to.words.resize((bits + BITMAP_WORD_BITS - 1) / BITMAP_WORD_BITS);
+	unsigned int shift = farmerLeft ? 1 : 0;
+	//each word kept pairs the states of two words
+	for(std::size_t w = 0; w < to.words.size(); ++w){
+		std::uint64_t low = evenBits(from.words[2 * w] >> shift);
+		std::uint64_t high = 2 * w + 1 < from.words.size() ? evenBits(from.words[2 * w + 1] >> shift) : 0;
+		to.words[w] = low | high << 32;
+	}
+}
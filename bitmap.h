@@ -0,0 +1,156 @@
+/**
+ * @file bitmap.h
+ * @brief Sets of states as bitmaps over every packed state of a puzzle.
+ *
+ * Bit s of a StateBitmap stands for the packed state s, so with N items a set
+ * takes 2^N bits. Flipping one item's bank maps the whole set through a fixed
+ * permutation of bit positions: items from the seventh up swap whole 64 bit
+ * words, and the first six move bits within each word by a delta swap. That
+ * lets a breadth first search move a whole layer of states at a time with
+ * plain word operations.
+ */
+
+#ifndef FWDC_BITMAP_H
+#define FWDC_BITMAP_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "state.h"
+
+class Puzzle;
+
+///@brief Bits per bitmap word, the low six bits of a state pick the bit within its word
+static const unsigned int BITMAP_WORD_BITS = 64;
+
+///@brief Most items a bitmap covers, 2^28 states take 32 MB
+static const unsigned int BITMAP_MAX_ITEMS = 28;
+
+/**
+ * @brief A set of packed states as one bit per state
+ */
+class StateBitmap{
+public:
+	std::vector <std::uint64_t> words;///<bit s % 64 of word s / 64 is state s
+
+	///@brief Size the bitmap for every state of a number of items and empty it
+	void reset(unsigned int items){
+		std::size_t bits = (std::size_t)1 << items;
+		words.assign((bits + BITMAP_WORD_BITS - 1) / BITMAP_WORD_BITS, 0);
+	}
+
+	bool test(State s)const{
+		return (words[s / BITMAP_WORD_BITS] >> (s % BITMAP_WORD_BITS)) & 1;
+	}
+
+	void set(State s){
+		words[s / BITMAP_WORD_BITS] |= (std::uint64_t)1 << (s % BITMAP_WORD_BITS);
+	}
+
+	///@brief Number of states in the set
+	std::size_t count()const{
+		std::size_t rval = 0;
+		for(std::size_t i = 0; i < words.size(); ++i)
+			rval += popcount(words[i]);
+		return rval;
+	}
+
+	///@brief Is the set empty?
+	bool none()const{
+		for(std::size_t i = 0; i < words.size(); ++i){
+			if(words[i] != 0)
+				return false;
+		}
+		return true;
+	}
+
+	///@brief Find a state in both this set and another
+	///@return True if there is one, which is then stored in s
+	bool firstCommon(const StateBitmap &other, State &s)const{
+		for(std::size_t i = 0; i < words.size(); ++i){
+			std::uint64_t both = words[i] & other.words[i];
+			if(both != 0){
+				s = (State)(i * BITMAP_WORD_BITS + lowestBit(both));
+				return true;
+			}
+		}
+		return false;
+	}
+
+	static unsigned int popcount(std::uint64_t w){
+#if defined(__GNUC__) || defined(__clang__)
+		return (unsigned int)__builtin_popcountll(w);
+#else
+		unsigned int rval = 0;
+		for(; w; w &= w - 1)
+			++rval;
+		return rval;
+#endif
+	}
+
+	static unsigned int lowestBit(std::uint64_t w){
+#if defined(__GNUC__) || defined(__clang__)
+		return (unsigned int)__builtin_ctzll(w);
+#else
+		unsigned int rval = 0;
+		for(; !(w & 1); w >>= 1)
+			++rval;
+		return rval;
+#endif
+	}
+};
+
+///@brief Positions within a word whose index has bit k clear, for k below 6
+static const std::uint64_t BIT_CLEAR_MASKS[6] = {
+	0x5555555555555555ull, 0x3333333333333333ull, 0x0F0F0F0F0F0F0F0Full,
+	0x00FF00FF00FF00FFull, 0x0000FFFF0000FFFFull, 0x00000000FFFFFFFFull
+};
+
+///@brief Move every bit of a word from position j to position j ^ low, for low below 64
+inline std::uint64_t xorPositions(std::uint64_t w, unsigned int low){
+	for(unsigned int k = 0; k < 6; ++k){
+		if(low & (1u << k)){
+			unsigned int shift = 1u << k;
+			w = ((w >> shift) & BIT_CLEAR_MASKS[k]) | ((w & BIT_CLEAR_MASKS[k]) << shift);
+		}
+	}
+	return w;
+}
+
+///@brief Positions j within a word whose states have bit k equal to value
+///@param word Index of the word, giving the state bits from 6 up
+inline std::uint64_t bitEquals(std::size_t word, unsigned int k, bool value){
+	std::uint64_t set;
+	if(k < 6)
+		set = ~BIT_CLEAR_MASKS[k];
+	else
+		set = (word >> (k - 6)) & 1 ? ~(std::uint64_t)0 : 0;
+	return value ? set : ~set;
+}
+
+///@brief Set a bitmap to the states of another with the farmer on one bank, dropping the farmer's bit
+///
+///The farmer crosses every time, so a layer of breadth first search has him on
+///the same bank in all its states and needs only half the bits. State s is bit
+///s >> 1 of the result.
+///@param items Items of the puzzle, at least the farmer
+///@param from The states, sized for items
+///@param farmerLeft The bank of the farmer in the states kept
+///@param to Set to the states kept, sized for one item fewer
+void dropFarmer(unsigned int items, const StateBitmap &from, bool farmerLeft, StateBitmap &to);
+
+///@brief Set a bitmap to the legal states of a puzzle with at most BITMAP_MAX_ITEMS items
+void findLegal(const Puzzle &puzzle, StateBitmap &legal);
+
+///@brief Set a bitmap to every state one crossing from a set, legal or not
+///
+///Rather than applying every boat load in turn, this rows the farmer across and
+///then brings along up to capacity items one at a time, each from the bank he left.
+///@param puzzle The puzzle, with at most BITMAP_MAX_ITEMS items
+///@param from The states crossed from
+///@param to Set to the states reached, sized like from
+///@param scratch Storage for the states partway through the crossing
+void crossRiver(const Puzzle &puzzle, const StateBitmap &from, StateBitmap &to, StateBitmap &scratch);
+
+#endif
@@ -0,0 +1,360 @@
+/**
+ * @file frontier.h
+ * @brief Problem space graph nodes and the frontiers that order them.
+ */
+
+#ifndef FWDC_FRONTIER_H
+#define FWDC_FRONTIER_H
+
+#include <algorithm>
+#include <cstddef>
+#include <map>
+#include <vector>
+
+#include "state.h"
+
+class Frontier;
+
+///@brief Fixed point scale of frontier priorities, so weighted A* can use fractional weights
+static const int WEIGHT_SCALE = 16;
+
+///@brief Hint that memory is about to be read, so its cache miss overlaps other work
+inline void prefetch(const void * address){
+#if defined(__GNUC__) || defined(__clang__)
+	__builtin_prefetch(address);
+#else
+	(void)address;
+#endif
+}
+
+/**
+ * @brief A fully generated problem space graph node with A* information
+ */
+struct PSNode {
+	State state;///<problem state itself
+	PSNode * parent;///<parent node in the problem space graph if any
+	Move move;///<the move that reached this node from parent, meaningless without a parent
+	int cost2reach;///<the cost of the moves taken to reach this node from the start, g()
+	int projectedCost;///<the heuristic estimate number of moves to complete the problem, h()
+	int priority;///<key of the node in the frontier, g()*WEIGHT_SCALE plus the weighted h()
+	bool open;///<is the node waiting in the frontier
+	unsigned char estimated;///<how many of SearchOptions::heuristics projectedCost takes in
+	std::vector <std::pair<Move, PSNode *> > children;///<the child nodes in the problem space graph and the moves reaching them
+
+	///@brief New problem space graph node given problem state and parent node.
+	///@param newstate The problem state of the node
+	///@param from The parent node, NULL for the start node
+	///@param via The move taken from the parent to reach this node
+	///@param estimate The heuristic estimate of the cost left from newstate
+	PSNode(State newstate, PSNode * from, Move via, int estimate){
+		state = newstate;
+		parent = from;
+		move = via;
+		if(NULL == from)
+			cost2reach = 0;
+		else
+			cost2reach = from->cost2reach + via.cost();
+		projectedCost = estimate;
+		priority = 0;
+		open = false;
+		estimated = 0;
+	}
+
+	///@brief Update the cost to reach this node (and any children) if new cost is better.
+	///@param newcost The cost of the new path to this node found.
+	///@param newparent The node to backtrack along this new path.
+	///@param via The move taken from newparent to reach this node
+	///@param frontier The frontier of the problem space graph to update  with a new f if neccesary
+	///@return True if the new path was supperior on the path was updated
+	bool updateCostCond(int newcost, PSNode * newparent, Move via, Frontier &frontier);
+};
+
+/**
+ * @brief The open nodes of a search, ordered by PSNode::priority
+ *
+ * Implementations own the PSNode::open flag: push() sets it and pop() clears it.
+ */
+class Frontier{
+public:
+	virtual ~Frontier(){}
+
+	///@brief Add a node keyed by its current priority
+	virtual void push(PSNode * node) = 0;
+
+	///@brief Re-key an open node whose priority has just been lowered
+	///@param node The node, already holding its new priority
+	///@param oldPriority The priority it was pushed with
+	virtual void decrease(PSNode * node, int oldPriority) = 0;
+
+	///@brief Remove the open node with the lowest priority
+	///@return The node, or NULL if the frontier is empty
+	virtual PSNode * pop() = 0;
+
+	///@brief Are there no open nodes left?
+	virtual bool empty()const = 0;
+
+	///@brief Remove all nodes
+	virtual void clear() = 0;
+
+	///@brief Get the open nodes in priority order, for tracing
+	virtual void list(std::vector <PSNode *> &out)const = 0;
+};
+
+inline bool PSNode::updateCostCond(int newcost, PSNode * newparent, Move via, Frontier &frontier){
+	if(newcost < cost2reach){
+		int oldPriority = priority;
+		priority -= (cost2reach - newcost) * WEIGHT_SCALE;
+		if(open)
+			frontier.decrease(this, oldPriority);//if in frontier re-key it with the new adjusted cost
+
+		cost2reach = newcost;
+		parent = newparent;
+		move = via;
+
+		//update any children
+		for(unsigned int i = 0; i < children.size(); ++i){
+			children[i].second->updateCostCond(newcost + children[i].first.cost(), this, children[i].first, frontier);
+		}
+		return true;
+	}
+	return false;
+}
+
+/**
+ * @brief Frontier kept in an ordered multimap, ties leave in the order they arrived
+ */
+class MultimapFrontier : public Frontier{
+public:
+	void push(PSNode * node){
+		node->open = true;
+		nodes.insert(std::pair<int, PSNode *>(node->priority, node));
+	}
+
+	void decrease(PSNode * node, int oldPriority){
+		for(std::multimap<int, PSNode*>::iterator iter = nodes.lower_bound(oldPriority); iter != nodes.upper_bound(oldPriority); iter++){
+			if(iter->second == node){
+				nodes.erase(iter);
+				nodes.insert(std::pair<int, PSNode *>(node->priority, node));
+				break;
+			}
+		}
+	}
+
+	PSNode * pop(){
+		if(nodes.empty())
+			return NULL;
+		PSNode * rval = nodes.begin()->second;
+		nodes.erase(nodes.begin());
+		rval->open = false;
+		return rval;
+	}
+
+	bool empty()const{
+		return nodes.empty();
+	}
+
+	void clear(){
+		nodes.clear();
+	}
+
+	void list(std::vector <PSNode *> &out)const{
+		out.clear();
+		for(std::multimap<int, PSNode*>::const_iterator iter = nodes.begin(); iter != nodes.end(); ++iter)
+			out.push_back(iter->second);
+	}
+
+private:
+	std::multimap <int, PSNode *> nodes;
+};
+
+/**
+ * @brief Frontier kept in an array binary heap
+ *
+ * A lowered priority pushes a second entry instead of searching the heap, and
+ * entries whose priority no longer matches their node are skipped when popped.
+ */
+class HeapFrontier : public Frontier{
+public:
+	HeapFrontier(){
+		live = 0;
+	}
+
+	void push(PSNode * node){
+		node->open = true;
+		++live;
+		pushEntry(node);
+	}
+
+	void decrease(PSNode * node, int){
+		pushEntry(node);
+	}
+
+	PSNode * pop(){
+		while(!heap.empty()){
+			Entry top = heap[0];
+			heap[0] = heap.back();
+			heap.pop_back();
+			if(!heap.empty()){
+				siftDown(0);
+				//the next pop reads this node's flags
+				prefetch(heap[0].node);
+			}
+			if(top.node->open and top.priority == top.node->priority){
+				top.node->open = false;
+				--live;
+				return top.node;
+			}
+		}
+		return NULL;
+	}
+
+	bool empty()const{
+		return live == 0;
+	}
+
+	void clear(){
+		heap.clear();
+		live = 0;
+	}
+
+	void list(std::vector <PSNode *> &out)const{
+		std::vector <Entry> sorted;
+		for(unsigned int i = 0; i < heap.size(); ++i){
+			if(heap[i].node->open and heap[i].priority == heap[i].node->priority)
+				sorted.push_back(heap[i]);
+		}
+		std::sort(sorted.begin(), sorted.end());
+		out.clear();
+		for(unsigned int i = 0; i < sorted.size(); ++i)
+			out.push_back(sorted[i].node);
+	}
+
+private:
+	struct Entry{
+		int priority;
+		PSNode * node;
+		bool operator<(const Entry &other)const{
+			return priority < other.priority;
+		}
+	};
+
+	std::vector <Entry> heap;
+	unsigned long live;///<number of open nodes, stale entries aside
+
+	void pushEntry(PSNode * node){
+		Entry entry = {node->priority, node};
+		heap.push_back(entry);
+		unsigned long i = heap.size() - 1;
+		while(i > 0 and entry < heap[(i - 1) / 2]){
+			heap[i] = heap[(i - 1) / 2];
+			i = (i - 1) / 2;
+		}
+		heap[i] = entry;
+	}
+
+	void siftDown(unsigned long i){
+		Entry entry = heap[i];
+		unsigned long size = heap.size();
+		for(;;){
+			unsigned long child = 2 * i + 1;
+			if(child >= size)
+				break;
+			//the four grandchildren share a cache line, fetch it while comparing the children
+			if(2 * child + 1 < size)
+				prefetch(&heap[2 * child + 1]);
+			if(child + 1 < size and heap[child + 1] < heap[child])
+				++child;
+			if(!(heap[child] < entry))
+				break;
+			heap[i] = heap[child];
+			i = child;
+		}
+		heap[i] = entry;
+	}
+};
+
+/**
+ * @brief Frontier kept in an array of buckets indexed by priority
+ *
+ * Priorities are small non-negative integers, so push and pop are constant time
+ * apart from scanning forward over empty buckets. Like HeapFrontier a lowered
+ * priority leaves a stale entry behind to be skipped.
+ */
+class BucketFrontier : public Frontier{
+public:
+	BucketFrontier(){
+		cursor = 0;
+		end = 0;
+		live = 0;
+	}
+
+	void push(PSNode * node){
+		node->open = true;
+		++live;
+		pushEntry(node);
+	}
+
+	void decrease(PSNode * node, int){
+		pushEntry(node);
+	}
+
+	PSNode * pop(){
+		while(live > 0 and cursor < buckets.size()){
+			std::vector <PSNode *> &bucket = buckets[cursor];
+			if(bucket.empty()){
+				++cursor;
+				continue;
+			}
+			PSNode * node = bucket.back();
+			bucket.pop_back();
+			if(node->open and node->priority == (int)cursor){
+				node->open = false;
+				--live;
+				return node;
+			}
+		}
+		return NULL;
+	}
+
+	bool empty()const{
+		return live == 0;
+	}
+
+	///@brief Remove all nodes, touching only the buckets used since the last clear
+	void clear(){
+		for(unsigned long i = cursor; i < end; ++i)
+			buckets[i].clear();
+		cursor = 0;
+		end = 0;
+		live = 0;
+	}
+
+	void list(std::vector <PSNode *> &out)const{
+		out.clear();
+		for(unsigned long i = cursor; i < buckets.size(); ++i){
+			for(unsigned long j = buckets[i].size(); j-- > 0;){
+				if(buckets[i][j]->open and buckets[i][j]->priority == (int)i)
+					out.push_back(buckets[i][j]);
+			}
+		}
+	}
+
+private:
+	std::vector <std::vector <PSNode *> > buckets;
+	unsigned long cursor;///<no bucket below this holds an entry
+	unsigned long end;///<no bucket from this up holds an entry
+	unsigned long live;///<number of open nodes, stale entries aside
+
+	void pushEntry(PSNode * node){
+		unsigned long i = (unsigned long)node->priority;
+		if(i >= buckets.size())
+			buckets.resize(i + 1);
+		buckets[i].push_back(node);
+		if(i < cursor)
+			cursor = i;
+		if(i >= end)
+			end = i + 1;
+	}
+};
+
+#endif
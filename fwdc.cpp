@@ -2,279 +2,333 @@
  * @file fwdc.cpp
  * @author Steven Clark
  * @date 9/25/2017
- * @brief Source code for A* solver for Farmer Wolf Duck & Corn logic problem.
+ * @brief Command line A* solver for Farmer Wolf Duck & Corn and other river crossing puzzles.
  */
 
 #include <iostream>
-#include <vector>
+#include <fstream>
+#include <sstream>
 #include <string>
-#include <map>
+#include <vector>
+#include <charconv>
+
+#include "solver.h"
 
 using std::string;
 using std::vector;
-using std::multimap;
-using std::map;
 using std::cout;
 using std::endl;
 
-/**
- * @brief Farmer Wolf Duck and Corn game state
- */
-class FWDCstate{
-public:
-	bool FL;///<is farmer on left bank of the river
-	bool WL;///<is wolf on left bank of the river
-	bool DL;///<is duck on left bank of the river
-	bool CL;///<is corn on left bank of the river
-
-	///@brief Construct a new state with all items on the right bank of the river
-	FWDCstate(){
-		FL = 0;
-		WL = 0;
-		DL = 0;
-		CL = 0;
-	}
-
-	///@brief Construct a new state with some items on the left bank of the river
-	///@param FF Is the farmer on the left bank?
-	///@param WW Is the wolf on the left bank?
-	///@param DD is the duck on the left bank?
-	///@param CC is the corn on the left bank?
-	FWDCstate(bool FF, bool WW, bool DD, bool CC){
-		FL=FF;
-		WL=WW;
-		DL=DD;
-		CL=CC;
-	}
-	///@brief Less than operator for placement in ordered data structures
-	///@note neccessary for use as an STL map or set key
-	bool operator<(const FWDCstate &other) const{
-		if(FL != other.FL){
-			return other.FL;
-		}else if(WL != other.WL){
-			return other.WL;
-		}else if(DL != other.DL){
-			return other.DL;
-		}else if(CL != other.CL){
-			return other.CL;
-		}else
-			return false;
-	}
-
-	bool operator==(const FWDCstate &other) const{
-		return FL == other.FL and WL == other.WL and DL == other.DL and CL == other.CL;
-	}
-
-	bool operator!=(const FWDCstate &other) const{
-		return FL != other.FL or WL != other.WL or DL != other.DL or CL != other.CL;
-	}
-
-	bool isWinning()const{
-		return FL and WL and DL and CL;
-	}
-
-	///@brief Computes a heuristic for all items to reach the left bank
-	int h()const{
-		return /*(int)!FL+*/(int)!WL+(int)!DL+(int)!CL;
-	}
-
-	///@brief Can the farmer and wolf be moved to the other bank next turn without creating an illegal state
-	bool canMoveFW()const{
-		return FL == WL and DL != CL;
-	}
-	///@brief Can the farmer and corn be moved to the other bank next turn without creating an illegal state
-	bool canMoveFC()const{
-		return FL == CL and WL != DL;
-	}
-	///@brief Can just the farmer be moved to the other bank next turn without creating an illegal state
-	bool canMoveF()const{
-		return DL != CL and WL != DL;
-	}
-	///@brief Can the farmer and duck be moved to the other bank next turn without creating an illegal state
-	bool canMoveFD()const{
-		return FL == DL;
-	}
-	///@brief Get all legal game states that can be expanded from this one
-	///@return a vector of states one move from this one
-	vector <FWDCstate> nextStates()const{
-		vector <FWDCstate> rvec;
-		if(canMoveFW())
-			rvec.push_back(FWDCstate(!FL,!WL,DL,CL));
-		if(canMoveFD())
-			rvec.push_back(FWDCstate(!FL,WL,!DL,CL));
-		if(canMoveFC())
-			rvec.push_back(FWDCstate(!FL,WL,DL,!CL));
-		if(canMoveF())
-			rvec.push_back(FWDCstate(!FL,WL,DL,CL));
-
-		return rvec;
-	}
-	///@brief Get a string representation of the problem state.
-	string toString()const{
-		string rval = "[";
-		if(FL)
-			rval.append("F");
-		if(WL)
-			rval.append("W");
-		if(DL)
-			rval.append("D");
-		if(CL)
-			rval.append("C");
-		rval.append("||");
-		if(!FL)
-			rval.append("F");
-		if(!WL)
-			rval.append("W");
-		if(!DL)
-			rval.append("D");
-		if(!CL)
-			rval.append("C");
-		rval.append("]");
-		return rval;
-	}
+///@brief Ways of printing a search result
+enum OutputFormat{
+	OUTPUT_TEXT,///<the path as states and moves, as the solver always printed it
+	OUTPUT_MOVES,///<one move per line
+	OUTPUT_CODE,///<the path as a PathCode
+	OUTPUT_JSON///<one JSON object per search
 };
 
-/**
- * @brief A fully generated problem space graph node with A* information
- */
-struct PSNode {
-	FWDCstate state;///<problem state itself
-	PSNode * parent;///<parent node in the problem space graph if any
-	int cost2reach;///<the number of moves taken to reach this node from the start, g()
-	int projectedCost;///<the heuristic estimate number of moves to complete the problem, h()
-	vector <PSNode *> children;///<the child nodes in the problem space graph
-
-	///@brief New problem space graph node given problem state and parent node.
-	PSNode(FWDCstate newstate, PSNode * from){
-		state = newstate;
-		parent = from;
-		if(NULL == from)
-			cost2reach = 0;
+///@brief Print a search result
+static void writeResult(std::ostream &out, const Puzzle &puzzle, State start, const SearchResult &result, OutputFormat format){
+	PathCode code(puzzle);
+	for(unsigned int i = 0; i < result.moves.size(); ++i)
+		code.push(result.moves[i]);
+	State state = start;
+
+	switch(format){
+	case OUTPUT_TEXT:
+		if(!result.found){
+			out << "No path to goal!" << endl;
+			break;
+		}
+		out << "Winning state reached." << endl;
+		puzzle.write(out, state);
+		for(unsigned int i = 0; i < result.moves.size(); ++i){
+			state ^= result.moves[i].carried;
+			out << ' ';
+			puzzle.write(out, result.moves[i]);
+			out << ' ';
+			puzzle.write(out, state);
+		}
+		out << endl;
+		out << "Encoded path:\t" << code.steps << " moves at " << code.bitsPerStep
+				<< " bits each: " << code.toHex() << endl;
+		break;
+	case OUTPUT_MOVES:
+		for(unsigned int i = 0; i < result.moves.size(); ++i){
+			puzzle.write(out, result.moves[i]);
+			out << endl;
+		}
+		if(!result.found)
+			out << "No path to goal!" << endl;
+		break;
+	case OUTPUT_CODE:
+		if(result.found)
+			out << code.steps << ' ' << code.toHex() << endl;
 		else
-			cost2reach = from->cost2reach + 1;
-		projectedCost = state.h();
+			out << "none" << endl;
+		break;
+	case OUTPUT_JSON:
+		out << "{\"found\":" << (result.found ? "true" : "false")
+				<< ",\"cost\":" << result.cost
+				<< ",\"expanded\":" << result.expanded
+				<< ",\"generated\":" << result.generated
+				<< ",\"evaluations\":" << result.evaluations
+				<< ",\"states\":[\"";
+		puzzle.write(out, state);
+		out << '"';
+		for(unsigned int i = 0; i < result.moves.size(); ++i){
+			state ^= result.moves[i].carried;
+			out << ",\"";
+			puzzle.write(out, state);
+			out << '"';
+		}
+		out << "],\"moves\":[";
+		for(unsigned int i = 0; i < result.moves.size(); ++i){
+			out << (i ? ",\"" : "\"");
+			puzzle.write(out, result.moves[i]);
+			out << '"';
+		}
+		out << "],\"code\":\"" << code.toHex() << "\"}" << endl;
+		break;
 	}
+}
 
-	///@brief Update the cost to reach this node (and any children) if new cost is better.
-	///@param newcost The cost of the new path to this node found.
-	///@param newparent The node to backtrack along this new path.
-	///@param frontier The frontier of the problem space graph to update  with a new f if neccesary
-	///@return True if the new path was supperior on the path was updated
-	bool updateCostCond(int newcost, PSNode * newparent, multimap<int, PSNode *> &frontier){
-		if(newcost < cost2reach){
-			//look for node in frontier
-			for(multimap<int, PSNode*>::iterator iter = frontier.lower_bound(cost2reach); iter != frontier.upper_bound(cost2reach); iter++){
-				if(iter->second == this){
-					frontier.erase(iter);//if in frontier remove it and emplace with new adjusted cost
-					frontier.insert(std::pair<int,PSNode *>(newcost+projectedCost,this));
-					break;
-				}
-			}
-
-			cost2reach = newcost;
-			parent = newparent;
+///@brief Longest list of heuristics taken, repeating one gains nothing
+static const unsigned int MAX_HEURISTICS = 8;
+
+static const char USAGE[] =
+	"usage: fwdc [options]\n"
+	"Solve a river crossing puzzle, by default the farmer, wolf, duck and corn.\n"
+	"\n"
+	"  -p, --puzzle FILE      puzzle definition file\n"
+	"  -s, --start STATE      start state, e.g. [||FWDC]\n"
+	"  -g, --goal STATE       goal state, e.g. [FWDC||]\n"
+	"  -b, --batch FILE       solve every \"START [GOAL]\" line of FILE, '-' for a default\n"
+	"  -d, --decode CODE      replay a \"STEPS HEX\" path code from the start instead of searching\n"
+	"  -a, --algorithm NAME   astar, weighted, ida, bfs, bidirectional, parallel,\n"
+	"                         bitmap, bdd, epea, lazy, paths, hierarchy or realtime (astar)\n"
+	"  -w, --weight W         heuristic weight for weighted A* (2)\n"
+	"  -l, --lookahead N      states the realtime search expands before each move (16)\n"
+	"  -f, --frontier NAME    multimap, heap or bucket frontier for A* (multimap)\n"
+	"  -e, --heuristics LIST  comma separated counting, crossings, pattern, landmarks and\n"
+	"                         learned, the largest is used and lazy A* evaluates them in\n"
+	"                         order, epea takes counting alone (counting)\n"
+	"  -L, --landmarks FILE   map landmark tables from FILE, building and saving them there first\n"
+	"  -C, --hierarchy FILE   map the contraction hierarchy from FILE, likewise\n"
+	"  -t, --trace LEVEL      0 quiet, 1 expansions, 2 everything (2)\n"
+	"  -j, --threads N        worker threads for the parallel search and preprocessing (1)\n"
+	"  -F, --filter on|off    Bloom filter in front of the table of generated states (off)\n"
+	"  -H, --huge-pages MODE  off, transparent or explicit huge pages for large tables (off)\n"
+	"  -o, --output FORMAT    text, moves, code or json (text)\n"
+	"  -h, --help             show this help\n";
+
+///@brief Report a command line error and return the exit status for it
+static int usageError(const string &message){
+	std::cerr << "fwdc: " << message << "\nTry 'fwdc --help'." << endl;
+	return 2;
+}
 
-			//update any children
-			for(unsigned int i = 0; i < children.size(); ++i){
-				children[i]->updateCostCond(newcost + 1, this, frontier);
-			}
-			return true;
-		}
-		return false;
+///@brief Look a name up in a null terminated table of names
+///@return The index of the name, -1 if it isn't there
+static int lookup(const char * const * table, const string &name){
+	for(int i = 0; table[i] != NULL; ++i){
+		if(name == table[i])
+			return i;
 	}
-};
-
-//used to simplify template syntax
-typedef std::pair<int,PSNode *> FrontierPair;
-typedef std::pair<FWDCstate, PSNode *> GeneratedPair;
+	return -1;
+}
 
 int main(int argc, char** argv){
-	PSNode * winningNode = NULL;
-
-	//map of all generated gamestates to their problem space graph nodes
-	map <FWDCstate, PSNode *> generated;
-
-	//map of all frontier nodes by their f() costs
-	multimap <int, PSNode *> frontier;
-
-	//node currently being evaluated, begins at problem start state;
-	PSNode *tempNode = new PSNode(FWDCstate(),NULL);
-	PSNode * workNode = NULL;//just a temp
-	string outpath, tempstring;//temps for formatting output of the wining path
-
-	//Add start state to generated nodes and frontier
-	generated.insert(GeneratedPair(tempNode->state, tempNode));
-	frontier.insert(FrontierPair(1,tempNode));
-
-	//While we haven't won or lost
-	while(winningNode == NULL and ! frontier.empty()){
-
-		//output the current frontier nodes
-		cout << "Frontier nodes are:\t";
-		for(multimap<int, PSNode*>::iterator iter = frontier.begin();
-				iter != frontier.end(); ++iter){
-			cout << iter->second->state.toString()
-					<< " h="<< iter->second->projectedCost
-					<< " g="<< iter->second->cost2reach
-					<< " f="<< iter->first << endl;
+	static const char * const algorithms[] = {"astar", "weighted", "ida", "bfs", "bidirectional", "parallel", "bitmap", "bdd", "epea", "lazy", "paths", "hierarchy", "realtime", NULL};
+	static const char * const frontiers[] = {"multimap", "heap", "bucket", NULL};
+	static const char * const formats[] = {"text", "moves", "code", "json", NULL};
+	static const char * const hugePages[] = {"off", "transparent", "explicit", NULL};
+	static const char * const heuristics[] = {"counting", "crossings", "pattern", "landmarks", "learned", NULL};
+	static const char * const optionNames[][2] = {{"-p", "--puzzle"}, {"-s", "--start"}, {"-g", "--goal"}, {"-b", "--batch"}, {"-d", "--decode"},
+			{"-a", "--algorithm"}, {"-w", "--weight"}, {"-l", "--lookahead"}, {"-f", "--frontier"}, {"-e", "--heuristics"}, {"-L", "--landmarks"}, {"-C", "--hierarchy"}, {"-t", "--trace"}, {"-j", "--threads"},
+			{"-F", "--filter"}, {"-H", "--huge-pages"}, {"-o", "--output"}, {NULL, NULL}};
+
+	SearchOptions options;
+	options.trace = 2;
+	OutputFormat format = OUTPUT_TEXT;
+	string puzzleFile, startText, goalText, batchFile, codeText;
+	bool weightSet = false, lookaheadSet = false;
+
+	for(int i = 1; i < argc; ++i){
+		string arg = argv[i], value;
+		if(arg == "-h" or arg == "--help"){
+			cout << USAGE;
+			return 0;
+		}
+		//every other option takes a value, either attached with '=' or as the next argument
+		string::size_type equals = arg.find('=');
+		if(arg.compare(0, 2, "--") == 0 and equals != string::npos){
+			value = arg.substr(equals + 1);
+			arg.erase(equals);
+		}
+		int option = -1;
+		for(int j = 0; optionNames[j][0] != NULL; ++j){
+			if(arg == optionNames[j][0] or arg == optionNames[j][1])
+				option = j;
+		}
+		if(option < 0)
+			return usageError("unknown option '" + arg + "'");
+		if(equals == string::npos or arg.compare(0, 2, "--") != 0){
+			if(i + 1 == argc)
+				return usageError("option '" + arg + "' needs a value");
+			value = argv[++i];
 		}
 
-		//chose the node with the lowest cost in the frontier
-		tempNode = frontier.begin()->second;
-		cout << "Expand:\t" << tempNode->state.toString() << endl;
-
-		//expand it
-		frontier.erase(frontier.begin());
-		vector<FWDCstate> tempChildren = tempNode->state.nextStates();
-		for(unsigned int i = 0; winningNode == NULL and i < tempChildren.size();++i){
-			if(tempChildren[i] != tempNode->state){//if generated state not that of parent
-				cout << "Generated:\t" << tempChildren[i].toString() << '\t';
-
-				//if state in question is already generated, updated if neccesary
-				if(generated.count(tempChildren[i]) > 0){
-					cout << "Regenerated\t";
-					if(generated[tempChildren[i]]->updateCostCond(tempNode->cost2reach+1, tempNode, frontier))
-						cout << "Updated F\t";
-					else
-						cout << "No update\t";
-				}else{//generate the graph node for this state
-					cout << "New node\t        \t";
-					workNode = new PSNode(tempChildren[i],tempNode);
-					generated.insert(GeneratedPair(workNode->state,workNode));
-					frontier.insert(FrontierPair(workNode->cost2reach + workNode->projectedCost,workNode));
-					if(workNode->state.isWinning()){
-						winningNode = workNode;
-					}
-				}
-
-				//Add the node, generated or new to the children of tempNode
-				tempNode->children.push_back(generated[tempChildren[i]]);
-
-				cout << "g=" << generated[tempChildren[i]]->cost2reach
-						<< " h=" << generated[tempChildren[i]]->projectedCost
-						<< " f=" << generated[tempChildren[i]]->cost2reach + generated[tempChildren[i]]->projectedCost
-						<< endl;
+		int index = 0;
+		unsigned int number = 0;
+		std::from_chars_result r = std::from_chars(value.data(), value.data() + value.size(), number);
+		bool isNumber = r.ec == std::errc() and r.ptr == value.data() + value.size();
+		if(arg == "-p" or arg == "--puzzle"){
+			puzzleFile = value;
+		}else if(arg == "-s" or arg == "--start"){
+			startText = value;
+		}else if(arg == "-g" or arg == "--goal"){
+			goalText = value;
+		}else if(arg == "-b" or arg == "--batch"){
+			batchFile = value;
+		}else if(arg == "-d" or arg == "--decode"){
+			codeText = value;
+		}else if(arg == "-a" or arg == "--algorithm"){
+			if((index = lookup(algorithms, value)) < 0)
+				return usageError("unknown algorithm '" + value + "'");
+			options.algorithm = (Algorithm)index;
+		}else if(arg == "-w" or arg == "--weight"){
+			r = std::from_chars(value.data(), value.data() + value.size(), options.weight);
+			if(r.ec != std::errc() or r.ptr != value.data() + value.size() or !(options.weight >= 1 and options.weight <= 64))
+				return usageError("weight must be a number from 1 to 64");
+			weightSet = true;
+		}else if(arg == "-l" or arg == "--lookahead"){
+			if(!isNumber or number < 1 or number > 1000000)
+				return usageError("lookahead must be from 1 to 1000000 states");
+			options.lookahead = number;
+			lookaheadSet = true;
+		}else if(arg == "-f" or arg == "--frontier"){
+			if((index = lookup(frontiers, value)) < 0)
+				return usageError("unknown frontier '" + value + "'");
+			options.frontier = (FrontierKind)index;
+		}else if(arg == "-e" or arg == "--heuristics"){
+			options.heuristics.clear();
+			for(string::size_type begin = 0; begin <= value.size();){
+				string::size_type comma = value.find(',', begin);
+				if(comma == string::npos)
+					comma = value.size();
+				if((index = lookup(heuristics, value.substr(begin, comma - begin))) < 0 or options.heuristics.size() == MAX_HEURISTICS)
+					return usageError("bad heuristic list '" + value + "'");
+				options.heuristics.push_back((Heuristic)index);
+				begin = comma + 1;
 			}
-
+		}else if(arg == "-L" or arg == "--landmarks"){
+			options.landmarkFile = value;
+		}else if(arg == "-C" or arg == "--hierarchy"){
+			options.hierarchyFile = value;
+		}else if(arg == "-t" or arg == "--trace"){
+			if(!isNumber or number > 2)
+				return usageError("trace level must be 0, 1 or 2");
+			options.trace = (int)number;
+		}else if(arg == "-j" or arg == "--threads"){
+			if(!isNumber or number < 1 or number > 256)
+				return usageError("thread count must be from 1 to 256");
+			options.threads = number;
+		}else if(arg == "-F" or arg == "--filter"){
+			if(value != "on" and value != "off")
+				return usageError("filter must be on or off");
+			options.filter = value == "on";
+		}else if(arg == "-H" or arg == "--huge-pages"){
+			if((index = lookup(hugePages, value)) < 0)
+				return usageError("huge pages must be off, transparent or explicit");
+			options.hugePages = (HugePages)index;
+		}else if(arg == "-o" or arg == "--output"){
+			if((index = lookup(formats, value)) < 0)
+				return usageError("unknown output format '" + value + "'");
+			format = (OutputFormat)index;
+		}else{
+			return usageError("unknown option '" + arg + "'");
 		}
 	}
-
-	//If the winning path was found, print it
-	if(winningNode != NULL){
-		cout << "Winning state reached." << endl;
-		for(workNode = winningNode; workNode != NULL; workNode = workNode->parent){
-			outpath = workNode->state.toString() + outpath;
-			if(workNode->parent != NULL)
-				outpath = " -> " + outpath;
+	if(weightSet and options.algorithm != ALGORITHM_WEIGHTED)
+		return usageError("--weight only applies to the weighted algorithm");
+	if(lookaheadSet and options.algorithm != ALGORITHM_REALTIME)
+		return usageError("--lookahead only applies to the realtime algorithm");
+	if(!options.heuristicsApply())
+		return usageError("the epea algorithm only takes the counting heuristic");
+	if(!codeText.empty() and !batchFile.empty())
+		return usageError("--decode replays a single path, not a batch");
+
+	Puzzle puzzle;
+	string error;
+	if(!puzzleFile.empty() and !puzzle.loadFile(puzzleFile, error)){
+		std::cerr << "fwdc: " << error << endl;
+		return 1;
+	}
+	State start = puzzle.start;
+	Goal goal(puzzle.goal, puzzle.all());
+	if(!startText.empty() and (!puzzle.parse(startText, start) or !puzzle.legal(start)))
+		return usageError("bad start state '" + startText + "'");
+	if(!goalText.empty() and !puzzle.parse(goalText, goal.state))
+		return usageError("bad goal state '" + goalText + "'");
+
+	SearchResult result;
+	if(!codeText.empty()){
+		//as printed by --output code, a path of no moves has no digits
+		PathCode code(puzzle);
+		std::istringstream in(codeText);
+		unsigned int steps = 0;
+		string hex, rest;
+		bool good = (bool)(in >> steps);
+		in >> hex;
+		if(!good or in >> rest or !code.fromHex(steps, hex))
+			return usageError("bad path code '" + codeText + "'");
+		if(!code.decode(puzzle, start, result.moves)){
+			std::cerr << "fwdc: path code '" << codeText << "' doesn't replay from the start state" << endl;
+			return 1;
 		}
-		cout << outpath << endl;
-	}else{
-		cout << "No path to goal!" << endl;
+		result.found = true;
+		result.cost = 0;
+		for(unsigned int i = 0; i < result.moves.size(); ++i)
+			result.cost += result.moves[i].cost();
+		writeResult(cout, puzzle, start, result, format);
+		return 0;
+	}
+
+	SolverContext solver;
+	solver.options = options;
+	if(batchFile.empty()){
+		solver.solve(puzzle, start, goal, result);
+		writeResult(cout, puzzle, start, result, format);
+		return 0;
 	}
 
-	//remove all nodes in the problem space graph from the heap
-	for(map <FWDCstate, PSNode *>::iterator iter = generated.begin(); iter != generated.end(); ++iter){
-		delete iter->second;
+	std::ifstream batch(batchFile.c_str());
+	if(!batch){
+		std::cerr << "fwdc: can't open '" << batchFile << "'" << endl;
+		return 1;
+	}
+	string line;
+	for(int number = 1; std::getline(batch, line); ++number){
+		string::size_type hash = line.find('#');
+		if(hash != string::npos)
+			line.erase(hash);
+		if(line.find_first_not_of(" \t\r") == string::npos)
+			continue;
+		if(!parseQuery(puzzle, line.data(), line.data() + line.size(), start, goal)){
+			std::cerr << "fwdc: " << batchFile << ": line " << number << ": bad query" << endl;
+			return 1;
+		}
+		if(format == OUTPUT_TEXT){
+			cout << "Query:\t";
+			puzzle.write(cout, start);
+			cout << ' ';
+			puzzle.write(cout, goal.state);
+			cout << endl;
+		}
+		solver.solve(puzzle, start, goal, result);
+		writeResult(cout, puzzle, start, result, format);
 	}
 	return 0;
 }
+
@@ -0,0 +1,215 @@
+/**
+ * @file fwdc_c.cpp
+ * @brief C interface to the river crossing solver.
+ *
+ * Each entry point catches everything the solver may throw, std::bad_alloc in
+ * practice, and turns it into a status code before returning to C.
+ */
+
+#include <algorithm>
+#include <cstring>
+#include <new>
+#include <string>
+
+#include "fwdc_c.h"
+#include "solver.h"
+
+///@brief The opaque context handed to C callers
+struct fwdc_context{
+	Puzzle puzzle;
+	SolverContext solver;
+	SearchResult result;///<kept so repeated solves reuse its move buffer
+	std::string error;
+};
+
+///@brief Map the exception being handled to a status code
+static int currentError(){
+	try{
+		throw;
+	}catch(const std::bad_alloc &){
+		return FWDC_ERROR_MEMORY;
+	}catch(...){
+		return FWDC_ERROR_INTERNAL;
+	}
+}
+
+///@brief Copy a status to a caller buffer as fwdc_format_state() does
+static int copyOut(const std::to_chars_result &r, char * buffer, size_t * written){
+	if(r.ec != std::errc())
+		return FWDC_ERROR_BUFFER;
+	*written = (size_t)(r.ptr - buffer);
+	return FWDC_OK;
+}
+
+int fwdc_abi_version(void){
+	return FWDC_ABI_VERSION;
+}
+
+fwdc_context * fwdc_context_create(void){
+	try{
+		return new fwdc_context;
+	}catch(...){
+		return NULL;
+	}
+}
+
+void fwdc_context_destroy(fwdc_context * context){
+	delete context;
+}
+
+int fwdc_load_puzzle(fwdc_context * context, const char * text, size_t length, char * error, size_t error_size){
+	if(context == NULL or (text == NULL and length > 0))
+		return FWDC_ERROR_ARGUMENT;
+	try{
+		if(context->puzzle.load(text, text + length, context->error))
+			return FWDC_OK;
+		if(error != NULL and error_size > 0){
+			size_t count = std::min(error_size - 1, context->error.size());
+			std::memcpy(error, context->error.data(), count);
+			error[count] = 0;
+		}
+		return FWDC_ERROR_PARSE;
+	}catch(...){
+		return currentError();
+	}
+}
+
+int fwdc_set_options(fwdc_context * context, const fwdc_options * options){
+	if(context == NULL or options == NULL
+			or options->algorithm < FWDC_ASTAR or options->algorithm > FWDC_REALTIME
+			or options->frontier < FWDC_MULTIMAP or options->frontier > FWDC_BUCKET
+			or !(options->weight >= 1 and options->weight <= 64)
+			or options->threads < 1 or options->threads > 256)
+		return FWDC_ERROR_ARGUMENT;
+	SearchOptions search = context->solver.options;
+	search.algorithm = (Algorithm)options->algorithm;
+	search.frontier = (FrontierKind)options->frontier;
+	search.weight = options->weight;
+	search.threads = options->threads;
+	//the options have no heuristic list, lazy A* has nothing to put off without the expensive ones
+	search.heuristics.assign(1, HEURISTIC_COUNTING);
+	if(options->algorithm == FWDC_LAZY){
+		search.heuristics.push_back(HEURISTIC_CROSSINGS);
+		search.heuristics.push_back(HEURISTIC_PATTERN);
+		search.heuristics.push_back(HEURISTIC_LANDMARKS);
+	}
+	if(!search.heuristicsApply())
+		return FWDC_ERROR_ARGUMENT;
+	context->solver.options = search;
+	return FWDC_OK;
+}
+
+int fwdc_get_options(const fwdc_context * context, fwdc_options * options){
+	if(context == NULL or options == NULL)
+		return FWDC_ERROR_ARGUMENT;
+	const SearchOptions &search = context->solver.options;
+	options->algorithm = search.algorithm;
+	options->frontier = search.frontier;
+	options->weight = search.weight;
+	options->threads = search.threads;
+	return FWDC_OK;
+}
+
+uint32_t fwdc_item_count(const fwdc_context * context){
+	return context == NULL ? 0 : (uint32_t)context->puzzle.items.size();
+}
+
+uint32_t fwdc_default_start(const fwdc_context * context){
+	return context == NULL ? 0 : context->puzzle.start;
+}
+
+uint32_t fwdc_default_goal(const fwdc_context * context){
+	return context == NULL ? 0 : context->puzzle.goal;
+}
+
+int fwdc_parse_state(const fwdc_context * context, const char * text, size_t length, uint32_t * state){
+	if(context == NULL or state == NULL or (text == NULL and length > 0))
+		return FWDC_ERROR_ARGUMENT;
+	State s = 0;
+	std::from_chars_result r = context->puzzle.parse(text, text + length, s);
+	if(r.ec != std::errc() or r.ptr != text + length)
+		return FWDC_ERROR_PARSE;
+	*state = s;
+	return FWDC_OK;
+}
+
+int fwdc_format_state(const fwdc_context * context, uint32_t state, char * buffer, size_t size, size_t * written){
+	if(context == NULL or buffer == NULL or written == NULL or (state & ~context->puzzle.all()) != 0)
+		return FWDC_ERROR_ARGUMENT;
+	return copyOut(context->puzzle.format(buffer, buffer + size, state), buffer, written);
+}
+
+int fwdc_format_move(const fwdc_context * context, fwdc_move move, char * buffer, size_t size, size_t * written){
+	if(context == NULL or buffer == NULL or written == NULL or (move.carried & ~context->puzzle.all()) != 0)
+		return FWDC_ERROR_ARGUMENT;
+	return copyOut(formatMove(buffer, buffer + size, Move(move.carried, move.to_left != 0), context->puzzle.names), buffer, written);
+}
+
+int fwdc_solve(fwdc_context * context, uint32_t start, uint32_t goal, fwdc_move * moves, size_t capacity, fwdc_result * result){
+	return fwdc_solve_masked(context, start, goal, context == NULL ? 0 : context->puzzle.all(), moves, capacity, result);
+}
+
+int fwdc_solve_masked(fwdc_context * context, uint32_t start, uint32_t goal, uint32_t goal_mask,
+		fwdc_move * moves, size_t capacity, fwdc_result * result){
+	if(context == NULL or result == NULL or (moves == NULL and capacity > 0))
+		return FWDC_ERROR_ARGUMENT;
+	State all = context->puzzle.all();
+	if((start & ~all) != 0 or (goal & ~all) != 0 or (goal_mask & ~all) != 0)
+		return FWDC_ERROR_ARGUMENT;
+	try{
+		SearchResult &found = context->result;
+		context->solver.solve(context->puzzle, start, Goal(goal, goal_mask), found);
+		result->found = found.found;
+		result->cost = found.cost;
+		result->length = found.moves.size();
+		result->expanded = found.expanded;
+		result->generated = found.generated;
+		if(!found.found)
+			return FWDC_NO_PATH;
+		if(found.moves.size() > capacity)
+			return FWDC_ERROR_BUFFER;
+		for(size_t i = 0; i < found.moves.size(); ++i){
+			moves[i].carried = found.moves[i].carried;
+			moves[i].to_left = found.moves[i].toLeft;
+		}
+		return FWDC_OK;
+	}catch(...){
+		return currentError();
+	}
+}
+
+int fwdc_next_move(fwdc_context * context, uint32_t start, uint32_t goal, fwdc_move * move){
+	if(context == NULL or move == NULL)
+		return FWDC_ERROR_ARGUMENT;
+	State all = context->puzzle.all();
+	if((start & ~all) != 0 or (goal & ~all) != 0)
+		return FWDC_ERROR_ARGUMENT;
+	try{
+		Move next;
+		if(!context->solver.nextMove(context->puzzle, start, goal, next))
+			return FWDC_NO_PATH;
+		move->carried = next.carried;
+		move->to_left = next.toLeft;
+		return FWDC_OK;
+	}catch(...){
+		return currentError();
+	}
+}
+
+int fwdc_realtime_move(fwdc_context * context, uint32_t current, uint32_t goal, fwdc_move * move){
+	if(context == NULL or move == NULL)
+		return FWDC_ERROR_ARGUMENT;
+	State all = context->puzzle.all();
+	if((current & ~all) != 0 or (goal & ~all) != 0)
+		return FWDC_ERROR_ARGUMENT;
+	try{
+		Move next;
+		if(!context->solver.realTimeMove(context->puzzle, current, Goal(goal, all), next))
+			return FWDC_NO_PATH;
+		move->carried = next.carried;
+		move->to_left = next.toLeft;
+		return FWDC_OK;
+	}catch(...){
+		return currentError();
+	}
+}
@@ -0,0 +1,184 @@
+/**
+ * @file fwdc_c.h
+ * @brief C interface to the river crossing solver, for callers that are not C++.
+ *
+ * Every function reports failure through its return value, never by throwing,
+ * and all output goes into buffers the caller owns. Text is passed as pointer
+ * and length and read in place, it need not be null terminated. A context is
+ * not thread safe, use one per thread.
+ * @code
+ * fwdc_context *context = fwdc_context_create();
+ * fwdc_move moves[64];
+ * fwdc_result result;
+ * if(fwdc_load_puzzle(context, text, length, NULL, 0) == FWDC_OK &&
+ *		fwdc_solve(context, fwdc_default_start(context), fwdc_default_goal(context), moves, 64, &result) == FWDC_OK)
+ *	...
+ * fwdc_context_destroy(context);
+ * @endcode
+ */
+
+#ifndef FWDC_C_H
+#define FWDC_C_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+///@brief Version of this interface, changes only when existing declarations change
+#define FWDC_ABI_VERSION 1
+
+///@brief Return values of the functions below
+enum fwdc_status{
+	FWDC_OK = 0,///<success, for fwdc_solve() a path was found
+	FWDC_NO_PATH = 1,///<fwdc_solve() searched everything reachable without finding the goal
+	FWDC_ERROR_ARGUMENT = -1,///<a pointer was null or a value out of range
+	FWDC_ERROR_PARSE = -2,///<a puzzle definition or state could not be read
+	FWDC_ERROR_BUFFER = -3,///<an output buffer was too small, nothing useful was written to it
+	FWDC_ERROR_MEMORY = -4,///<the solver ran out of memory
+	FWDC_ERROR_INTERNAL = -5///<anything else went wrong inside the solver
+};
+
+///@brief Search algorithms, see Algorithm in solver.h
+enum fwdc_algorithm{
+	FWDC_ASTAR = 0,
+	FWDC_WEIGHTED = 1,
+	FWDC_IDA = 2,
+	FWDC_BFS = 3,
+	FWDC_BIDIRECTIONAL = 4,
+	FWDC_PARALLEL = 5,
+	FWDC_BITMAP = 6,
+	FWDC_BDD = 7,
+	FWDC_EPEA = 8,
+	FWDC_LAZY = 9,///<lazy A* over the counting, crossings, pattern database and landmark heuristics
+	FWDC_PATHS = 10,///<moves looked up in a compressed path database, see fwdc_next_move()
+	FWDC_HIERARCHY = 11,///<contraction hierarchy, preprocessed with the threads option on the first solve
+	FWDC_REALTIME = 12///<real-time adaptive A*, not optimal, see fwdc_realtime_move()
+};
+
+///@brief Frontiers for A*, see FrontierKind in solver.h
+enum fwdc_frontier{
+	FWDC_MULTIMAP = 0,
+	FWDC_HEAP = 1,
+	FWDC_BUCKET = 2
+};
+
+///@brief Solver state, created by fwdc_context_create()
+typedef struct fwdc_context fwdc_context;
+
+///@brief How fwdc_solve() searches
+typedef struct fwdc_options{
+	int algorithm;///<an fwdc_algorithm
+	int frontier;///<an fwdc_frontier
+	double weight;///<heuristic weight for FWDC_WEIGHTED, at least 1
+	unsigned int threads;///<worker threads for FWDC_PARALLEL, at least 1
+} fwdc_options;
+
+///@brief One crossing of a solution
+typedef struct fwdc_move{
+	uint32_t carried;///<packed bitmask of the items in the boat, farmer included
+	int32_t to_left;///<nonzero if the boat crosses to the left bank
+} fwdc_move;
+
+///@brief What fwdc_solve() found
+typedef struct fwdc_result{
+	int32_t found;///<nonzero if a path was found
+	int32_t cost;///<cost of the path, -1 if none
+	size_t length;///<number of moves in the path, also set when the move buffer is too small
+	uint64_t expanded;///<number of nodes expanded
+	uint64_t generated;///<number of nodes generated
+} fwdc_result;
+
+///@brief Get FWDC_ABI_VERSION of the library actually linked
+int fwdc_abi_version(void);
+
+///@brief Create a context holding the farmer, wolf, duck and corn puzzle and default options
+///@return The context, or null if out of memory
+fwdc_context * fwdc_context_create(void);
+
+///@brief Free a context and everything it holds, null is ignored
+void fwdc_context_destroy(fwdc_context * context);
+
+///@brief Replace the context's puzzle with one read from a puzzle definition, see Puzzle in puzzle.h
+///@param context The context
+///@param text The definition, need not be null terminated
+///@param length Length of text in bytes
+///@param error If not null, receives a null terminated description of a parse error, truncated to fit
+///@param error_size Size of the error buffer
+///@return FWDC_OK, or FWDC_ERROR_PARSE leaving the puzzle unchanged
+int fwdc_load_puzzle(fwdc_context * context, const char * text, size_t length, char * error, size_t error_size);
+
+///@brief Set how fwdc_solve() searches
+int fwdc_set_options(fwdc_context * context, const fwdc_options * options);
+
+///@brief Get how fwdc_solve() searches
+int fwdc_get_options(const fwdc_context * context, fwdc_options * options);
+
+///@brief Number of items in the puzzle, the farmer included
+uint32_t fwdc_item_count(const fwdc_context * context);
+
+///@brief The puzzle's default start state, 0 for a null context
+uint32_t fwdc_default_start(const fwdc_context * context);
+
+///@brief The puzzle's default goal state, 0 for a null context
+uint32_t fwdc_default_goal(const fwdc_context * context);
+
+///@brief Read a state in the bracket notation, e.g. "[FWD||C]"
+///@param context The context whose puzzle names the items
+///@param text The state, need not be null terminated
+///@param length Length of text in bytes
+///@param state Receives the packed state
+///@return FWDC_OK, or FWDC_ERROR_PARSE unless text is exactly one state
+int fwdc_parse_state(const fwdc_context * context, const char * text, size_t length, uint32_t * state);
+
+///@brief Write a state in the bracket notation, without a null terminator
+///@param context The context whose puzzle names the items
+///@param state The packed state
+///@param buffer Receives the text
+///@param size Size of buffer
+///@param written Receives the number of bytes written
+///@return FWDC_OK, or FWDC_ERROR_BUFFER if it does not fit
+int fwdc_format_state(const fwdc_context * context, uint32_t state, char * buffer, size_t size, size_t * written);
+
+///@brief Write a move, e.g. "<-FD-", without a null terminator, see fwdc_format_state()
+int fwdc_format_move(const fwdc_context * context, fwdc_move move, char * buffer, size_t size, size_t * written);
+
+///@brief Search for a path from a start state to a goal state
+///@param context The context
+///@param start The packed start state
+///@param goal The packed goal state, every item matters
+///@param moves Receives the moves of the path
+///@param capacity Number of moves that fit in moves, moves may be null if this is 0
+///@param result Receives the outcome, length is set even when moves is too small
+///@return FWDC_OK, FWDC_NO_PATH, or FWDC_ERROR_BUFFER if the path has more than capacity moves
+int fwdc_solve(fwdc_context * context, uint32_t start, uint32_t goal, fwdc_move * moves, size_t capacity, fwdc_result * result);
+
+///@brief Like fwdc_solve(), but only the items in goal_mask have to reach their bank in goal
+int fwdc_solve_masked(fwdc_context * context, uint32_t start, uint32_t goal, uint32_t goal_mask,
+		fwdc_move * moves, size_t capacity, fwdc_result * result);
+
+///@brief Get the first move of an optimal path from one state to another, the question a service
+///	answers most, without searching once the context has built a compressed path database
+///@param context The context
+///@param start The packed state to move from
+///@param goal The packed state to reach, every item matters
+///@param move Receives the move
+///@return FWDC_OK, or FWDC_NO_PATH if goal can't be reached or is start
+int fwdc_next_move(fwdc_context * context, uint32_t start, uint32_t goal, fwdc_move * move);
+
+///@brief Get a move towards a goal in time bounded whatever the size of the puzzle, for
+///	callers that have to act within a deadline, see SolverContext::realTimeMove() in solver.h
+///@param context The context, which keeps what each call learns about the states it looked at
+///@param current The packed state to move from
+///@param goal The packed state to reach, every item matters
+///@param move Receives the move, making it and asking again from there reaches goal
+///@return FWDC_OK, or FWDC_NO_PATH if goal can't be reached or is current
+int fwdc_realtime_move(fwdc_context * context, uint32_t current, uint32_t goal, fwdc_move * move);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
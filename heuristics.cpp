@@ -0,0 +1,313 @@
+/**
+ * @file heuristics.cpp
+ * @brief Building pattern databases and landmark tables, and the table behind learned costs.
+ */
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdint>
+#include <fstream>
+
+#include "bitmap.h"
+#include "heuristics.h"
+#include "pages.h"
+
+using std::vector;
+
+void PatternDatabase::prepare(const Puzzle &puzzle, const Goal &goal){
+	if(built and builtItems == puzzle.items.size() and builtCapacity == puzzle.capacity
+			and builtConflicts == puzzle.conflicts and builtGoal.state == goal.state and builtGoal.mask == goal.mask)
+		return;
+	built = true;
+	builtItems = puzzle.items.size();
+	builtCapacity = puzzle.capacity;
+	builtConflicts = puzzle.conflicts;
+	builtGoal = goal;
+
+	//keep the farmer and the items in the most conflicts, they constrain the moves the most
+	vector <unsigned int> conflictCount(puzzle.items.size(), 0);
+	for(unsigned int i = 0; i < puzzle.conflicts.size(); ++i){
+		for(unsigned int j = 1; j < puzzle.items.size(); ++j)
+			conflictCount[j] += puzzle.conflicts[i] >> j & 1;
+	}
+	vector <unsigned int> order;
+	vector <bool> taken(puzzle.items.size(), false);
+	while(order.size() + 1 < puzzle.items.size() and order.size() + 1 < MAX_ITEMS){
+		unsigned int best = 0;
+		for(unsigned int j = 1; j < puzzle.items.size(); ++j){
+			if(!taken[j] and (best == 0 or conflictCount[j] > conflictCount[best]))
+				best = j;
+		}
+		taken[best] = true;
+		order.push_back(best);
+	}
+	std::sort(order.begin(), order.end());
+	kept.assign(1, 0);
+	kept.insert(kept.end(), order.begin(), order.end());
+
+	//the projected puzzle, assigning it builds its boat loads
+	Puzzle cut;
+	cut.items.clear();
+	cut.conflicts.clear();
+	State goalState = 0, goalMask = 0;
+	for(unsigned int i = 0; i < kept.size(); ++i){
+		cut.items.push_back(puzzle.items[kept[i]]);
+		goalState |= (goal.state >> kept[i] & 1) << i;
+		goalMask |= (goal.mask >> kept[i] & 1) << i;
+	}
+	for(unsigned int c = 0; c < puzzle.conflicts.size(); ++c){
+		State projected = 0;
+		for(unsigned int i = 0; i < kept.size(); ++i)
+			projected |= (puzzle.conflicts[c] >> kept[i] & 1) << i;
+		if(projected != 0 and (projected & (projected - 1)) != 0)
+			cut.conflicts.push_back(projected);
+	}
+	cut.capacity = puzzle.capacity;
+	projection = cut;
+	Goal target(goalState, goalMask);
+
+	//breadth first from every legal goal state at once
+	distances.assign((std::size_t)1 << kept.size(), (unsigned char)UNREACHABLE);
+	vector <State> layer, next;
+	for(State s = 0; s <= projection.all(); ++s){
+		if(target.matches(s) and projection.legal(s)){
+			distances[s] = 0;
+			layer.push_back(s);
+		}
+	}
+	vector <Move> moves;
+	for(int depth = 1; !layer.empty() and depth < UNREACHABLE; ++depth){
+		next.clear();
+		for(unsigned int i = 0; i < layer.size(); ++i){
+			projection.nextMoves(layer[i], moves);
+			for(unsigned int j = 0; j < moves.size(); ++j){
+				State child = layer[i] ^ moves[j].carried;
+				if(distances[child] == UNREACHABLE){
+					distances[child] = (unsigned char)depth;
+					next.push_back(child);
+				}
+			}
+		}
+		layer.swap(next);
+	}
+}
+
+///@brief First word of a landmark file
+static const std::uint32_t LANDMARK_MAGIC = 0x4C415746;//"FWAL" read little endian
+static const std::uint32_t LANDMARK_VERSION = 1;
+///@brief The tables start on a cache line after the header
+static const std::size_t LANDMARK_ALIGN = 64;
+
+LandmarkTable::LandmarkTable(){
+	items = 0;
+	capacity = 0;
+	built = false;
+	distances = NULL;
+	mapping = NULL;
+	mappedBytes = 0;
+	targeted = false;
+}
+
+LandmarkTable::~LandmarkTable(){
+	release();
+}
+
+void LandmarkTable::release(){
+	if(mapping != NULL)
+		unmapFile(mapping, mappedBytes);
+	mapping = NULL;
+	mappedBytes = 0;
+	distances = NULL;
+	owned.clear();
+	landmarks.clear();
+	built = false;
+	targeted = false;
+}
+
+bool LandmarkTable::prepare(const Puzzle &puzzle, const std::string &path){
+	if(built and sameRules(puzzle))
+		return true;
+	release();
+	if(!path.empty() and load(path, puzzle))
+		return true;
+	build(puzzle);
+	return path.empty() or save(path);
+}
+
+void LandmarkTable::build(const Puzzle &puzzle){
+	items = (unsigned int)puzzle.items.size();
+	capacity = puzzle.capacity;
+	conflicts = puzzle.conflicts;
+	built = true;
+	targeted = false;
+	if(items > MAX_ITEMS)
+		return;
+
+	std::size_t states = (std::size_t)1 << items;
+	StateBitmap legal, layer, next, seen, scratch;
+	findLegal(puzzle, legal);
+	//distance from each state to its closest landmark so far, the next landmark is the farthest
+	vector <unsigned char> closest(states, (unsigned char)UNREACHABLE);
+	for(unsigned int l = 0; l < LANDMARKS; ++l){
+		State landmark = 0;
+		if(l == 0){
+			landmark = puzzle.all();
+		}else if(l > 1){
+			int farthest = 0;
+			for(State s = 0; s < states; ++s){
+				if(closest[s] != UNREACHABLE and closest[s] > farthest){
+					farthest = closest[s];
+					landmark = s;
+				}
+			}
+			if(farthest == 0)
+				break;
+		}
+		landmarks.push_back(landmark);
+		owned.resize(landmarks.size() * states, (unsigned char)UNREACHABLE);
+		unsigned char * table = &owned[l * states];
+
+		//breadth first a layer at a time, writing down the depth of each state as it is reached
+		layer.reset(items);
+		layer.set(landmark);
+		seen = layer;
+		for(int depth = 0; !layer.none() and depth < UNREACHABLE; ++depth){
+			for(std::size_t w = 0; w < layer.words.size(); ++w){
+				for(std::uint64_t bits = layer.words[w]; bits != 0; bits &= bits - 1)
+					table[w * BITMAP_WORD_BITS + StateBitmap::lowestBit(bits)] = (unsigned char)depth;
+			}
+			crossRiver(puzzle, layer, next, scratch);
+			for(std::size_t w = 0; w < next.words.size(); ++w){
+				next.words[w] &= legal.words[w] & ~seen.words[w];
+				seen.words[w] |= next.words[w];
+			}
+			layer.words.swap(next.words);
+		}
+		if(!layer.none()){
+			//states too far for a byte would make the bound unsafe, drop the landmark
+			landmarks.pop_back();
+			owned.resize(landmarks.size() * states);
+			break;
+		}
+		for(State s = 0; s < states; ++s)
+			closest[s] = std::min(closest[s], table[s]);
+	}
+	distances = owned.empty() ? NULL : &owned[0];
+}
+
+void LandmarkTable::target(const Goal &newGoal){
+	if(targeted and goal.state == newGoal.state and goal.mask == newGoal.mask)
+		return;
+	goal = newGoal;
+	targeted = true;
+	nearest.assign(landmarks.size() * 256, 0);
+	State all = (1u << items) - 1;
+	State free = all & ~goal.mask, fixed = goal.state & goal.mask & all;
+	for(unsigned int l = 0; l < landmarks.size(); ++l){
+		//the distances from the landmark that some goal state has
+		bool present[256] = {};
+		bool any = false;
+		const unsigned char * table = distances + ((std::size_t)l << items);
+		for(State sub = 0;; sub = (sub - free) & free){
+			unsigned char d = table[fixed | sub];
+			if(d != UNREACHABLE)
+				present[d] = any = true;
+			if(sub == free)
+				break;
+		}
+		if(!any)
+			continue;
+		//a goal state's distance below and above each distance, the bound is the nearer one
+		unsigned char * row = &nearest[l * 256];
+		int below = -1;
+		for(int d = 0; d < 256; ++d){
+			if(present[d])
+				below = d;
+			row[d] = (unsigned char)(below < 0 ? 255 : d - below);
+		}
+		int above = -1;
+		for(int d = 255; d >= 0; --d){
+			if(present[d])
+				above = d;
+			if(above >= 0 and above - d < row[d])
+				row[d] = (unsigned char)(above - d);
+		}
+	}
+}
+
+bool LandmarkTable::save(const std::string &path)const{
+	//written beside the file and renamed over it, so a reader never maps half a table
+	std::string temporary = path + ".tmp";
+	std::ofstream out(temporary.c_str(), std::ios::binary | std::ios::trunc);
+	std::uint32_t header[6] = {LANDMARK_MAGIC, LANDMARK_VERSION, items, capacity,
+			(std::uint32_t)conflicts.size(), (std::uint32_t)landmarks.size()};
+	out.write((const char *)header, sizeof(header));
+	for(unsigned int i = 0; i < conflicts.size(); ++i){
+		std::uint32_t conflict = conflicts[i];
+		out.write((const char *)&conflict, sizeof(conflict));
+	}
+	for(unsigned int i = 0; i < landmarks.size(); ++i){
+		std::uint32_t landmark = landmarks[i];
+		out.write((const char *)&landmark, sizeof(landmark));
+	}
+	std::size_t written = sizeof(header) + 4 * (conflicts.size() + landmarks.size());
+	static const char padding[LANDMARK_ALIGN] = {};
+	out.write(padding, (std::streamsize)((LANDMARK_ALIGN - written % LANDMARK_ALIGN) % LANDMARK_ALIGN));
+	if(!landmarks.empty())
+		out.write((const char *)distances, (std::streamsize)(landmarks.size() << items));
+	out.close();
+	if(!out or std::rename(temporary.c_str(), path.c_str()) != 0){
+		std::remove(temporary.c_str());
+		return false;
+	}
+	return true;
+}
+
+bool LandmarkTable::load(const std::string &path, const Puzzle &puzzle){
+	std::size_t bytes = 0;
+	const void * file = mapFile(path.c_str(), bytes);
+	if(file == NULL)
+		return false;
+	const std::uint32_t * header = (const std::uint32_t *)file;
+	std::size_t words = bytes / 4;
+	bool good = words >= 6 and header[0] == LANDMARK_MAGIC and header[1] == LANDMARK_VERSION
+			and header[2] == puzzle.items.size() and header[3] == puzzle.capacity and header[4] == puzzle.conflicts.size()
+			and header[5] <= LANDMARKS and words >= 6 + header[4] + header[5];
+	for(unsigned int i = 0; good and i < header[4]; ++i)
+		good = header[6 + i] == puzzle.conflicts[i];
+	std::size_t offset = 0;
+	if(good){
+		offset = (4 * (6 + header[4] + header[5]) + LANDMARK_ALIGN - 1) / LANDMARK_ALIGN * LANDMARK_ALIGN;
+		//build() chooses no landmarks for puzzles too large for their tables
+		std::size_t tables = header[2] > MAX_ITEMS ? 0 : (std::size_t)header[5] << header[2];
+		good = (header[2] <= MAX_ITEMS or header[5] == 0) and bytes == offset + tables;
+	}
+	if(!good){
+		unmapFile(file, bytes);
+		return false;
+	}
+	items = (unsigned int)puzzle.items.size();
+	capacity = puzzle.capacity;
+	conflicts = puzzle.conflicts;
+	built = true;
+	targeted = false;
+	landmarks.assign(header + 6 + header[4], header + 6 + header[4] + header[5]);
+	mapping = file;
+	mappedBytes = bytes;
+	distances = (const unsigned char *)file + offset;
+	return true;
+}
+
+void LearnedHeuristic::prepare(const Puzzle &puzzle, const Goal &newGoal){
+	if(built and items == puzzle.items.size() and capacity == puzzle.capacity and conflicts == puzzle.conflicts
+			and goal.state == newGoal.state and goal.mask == newGoal.mask)
+		return;
+	items = (unsigned int)puzzle.items.size();
+	capacity = puzzle.capacity;
+	conflicts = puzzle.conflicts;
+	goal = newGoal;
+	built = true;
+	costs.clear();
+	if(items <= MAX_ITEMS)
+		costs.assign((std::size_t)1 << items, 0);
+}
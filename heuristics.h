@@ -0,0 +1,193 @@
+/**
+ * @file heuristics.h
+ * @brief The heuristics the A* family can combine, and the tables behind the stronger ones.
+ */
+
+#ifndef FWDC_HEURISTICS_H
+#define FWDC_HEURISTICS_H
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#include "puzzle.h"
+
+///@brief Heuristics for the A* family, each admissible and consistent so their maximum is too
+enum Heuristic{
+	HEURISTIC_COUNTING,///<Puzzle::h(), the items on the wrong bank over the boat capacity
+	HEURISTIC_CROSSINGS,///<Puzzle::crossings(), the wrong items counted separately for each direction
+	HEURISTIC_PATTERN,///<PatternDatabase, exact distances in the puzzle cut down to some of its items
+	HEURISTIC_LANDMARKS,///<LandmarkTable, the triangle inequality over exact distances from a few states
+	HEURISTIC_LEARNED///<LearnedHeuristic, costs to the goal learned searching for it before, Adaptive A*
+};
+
+/**
+ * @brief Distances to a goal in a puzzle projected onto a subset of its items
+ *
+ * Dropping items keeps the farmer, the capacity and the conflicts between the
+ * items kept, so every move of the full puzzle is a move of the projection and
+ * the exact distance there never overestimates. The items kept are the farmer
+ * and those in the most conflicts. The database is built by a breadth first
+ * search of the projection from its goal states, which works since a crossing
+ * can always be undone, and kept until the puzzle or goal changes.
+ */
+class PatternDatabase{
+public:
+	static const unsigned int MAX_ITEMS = 12;///<items kept, the farmer included, for 4096 entries
+	static const int UNREACHABLE = 255;///<distance of a state that can't reach the goal, nor can any state it projects from
+
+	PatternDatabase(){
+		built = false;
+	}
+
+	///@brief Build the database for a puzzle and goal, unless it was built for them last
+	void prepare(const Puzzle &puzzle, const Goal &goal);
+
+	///@brief Lower bound on the number of moves from a state to the goal prepared for
+	int h(State s)const{
+		State index = 0;
+		for(unsigned int i = 0; i < kept.size(); ++i)
+			index |= (s >> kept[i] & 1) << i;
+		return distances[index];
+	}
+
+private:
+	std::vector <unsigned int> kept;///<the items of the full puzzle kept, in bit order of the projection
+	std::vector <unsigned char> distances;///<moves to the goal by projected state
+	Puzzle projection;
+
+	bool built;
+	std::size_t builtItems;///<the puzzle and goal the database was built for
+	unsigned int builtCapacity;
+	std::vector <State> builtConflicts;
+	Goal builtGoal;
+};
+
+/**
+ * @brief Exact distances from a few landmark states to every state, for the ALT heuristic
+ *
+ * A crossing can always be undone, so the distance from a landmark L to a state is
+ * also the distance back, and by the triangle inequality d(s, g) >= |d(L, s) - d(L, g)|
+ * for every landmark. The landmarks are everything on the left bank, everything on
+ * the right bank, then each time the state farthest from the landmarks so far. The
+ * tables take one byte per state per landmark, are built by breadth first search
+ * over bitmaps, and can be saved to a file that later runs map instead of rebuilding.
+ */
+class LandmarkTable{
+public:
+	static const unsigned int MAX_ITEMS = 24;///<a landmark's table takes 2^items bytes, 16 MB here
+	static const unsigned int LANDMARKS = 4;///<landmarks chosen, fewer if the puzzle has fewer reachable states
+	static const int UNREACHABLE = 255;///<distance to a state in another component, or farther than a byte holds
+
+	LandmarkTable();
+	~LandmarkTable();
+
+	///@brief Get the tables for a puzzle, unless they are for it already
+	///@param puzzle The puzzle, with no tables and h() always 0 above MAX_ITEMS items
+	///@param path File to map the tables from, or to save them to if it doesn't hold them for this
+	///	puzzle; empty to keep them in memory only
+	///@return False if the file could not be written, the tables are in memory all the same
+	bool prepare(const Puzzle &puzzle, const std::string &path);
+
+	///@brief Set the goal h() measures to
+	void target(const Goal &goal);
+
+	///@brief Lower bound on the number of moves from a state to the goal
+	int h(State s)const{
+		int rval = 0;
+		for(unsigned int l = 0; l < landmarks.size(); ++l){
+			int d = distances[((std::size_t)l << items) + s];
+			if(d != UNREACHABLE)
+				rval = std::max(rval, (int)nearest[l * 256 + d]);
+		}
+		return rval;
+	}
+
+	///@brief The landmark states chosen
+	const std::vector <State> &chosen()const{
+		return landmarks;
+	}
+
+	///@brief Are the tables mapped from a file rather than built in memory?
+	bool mapped()const{
+		return mapping != NULL;
+	}
+
+	///@brief Write the tables to a file, replacing it
+	bool save(const std::string &path)const;
+
+	///@brief Map the tables from a file, if it holds them for a puzzle
+	bool load(const std::string &path, const Puzzle &puzzle);
+
+private:
+	unsigned int items;///<the puzzle the tables are for
+	unsigned int capacity;
+	std::vector <State> conflicts;
+	bool built;
+	std::vector <State> landmarks;
+	const unsigned char * distances;///<a table of 2^items bytes per landmark, in owned or the mapping
+	std::vector <unsigned char> owned;
+	const void * mapping;
+	std::size_t mappedBytes;
+	std::vector <unsigned char> nearest;///<per landmark and distance, how close some goal state's distance is
+	Goal goal;
+	bool targeted;
+
+	LandmarkTable(const LandmarkTable &);
+	LandmarkTable &operator=(const LandmarkTable &);
+
+	bool sameRules(const Puzzle &puzzle)const{
+		return items == puzzle.items.size() and capacity == puzzle.capacity and conflicts == puzzle.conflicts;
+	}
+
+	void build(const Puzzle &puzzle);
+	void release();
+};
+
+/**
+ * @brief Costs to a goal learned by earlier searches for it, for Adaptive A*
+ *
+ * When an optimal search from some start reaches the goal at cost C, every state s
+ * it expanded was reached from the start in g(s), so C <= g(s) + h*(s) and C - g(s)
+ * never overestimates the cost left from s. Raising the learned cost of each state
+ * expanded to that keeps the heuristic consistent, and later searches for the same
+ * goal expand fewer states while still finding optimal paths. Costs take a byte per
+ * state and are kept until the puzzle or goal changes.
+ */
+class LearnedHeuristic{
+public:
+	static const unsigned int MAX_ITEMS = 24;///<a byte per state, 16 MB here
+	static const int UNREACHABLE = 255;///<cost learned for a state that can't reach the goal, or is at least this far from it
+
+	LearnedHeuristic(){
+		items = 0;
+		capacity = 0;
+		built = false;
+	}
+
+	///@brief Start learning for a puzzle and goal, forgetting everything if they are not the ones learned for
+	///@param puzzle The puzzle, with nothing learned and h() always 0 above MAX_ITEMS items
+	///@param goal The goal the costs are to
+	void prepare(const Puzzle &puzzle, const Goal &goal);
+
+	///@brief Lower bound on the number of moves from a state to the goal, 0 if nothing was learned for it
+	int h(State s)const{
+		return costs.empty() ? 0 : costs[s];
+	}
+
+	///@brief Raise the cost learned for a state, if it is more than what is known
+	void learn(State s, int cost){
+		if(!costs.empty() and cost > costs[s])
+			costs[s] = (unsigned char)(cost < UNREACHABLE ? cost : UNREACHABLE);
+	}
+
+private:
+	unsigned int items;///<the puzzle and goal the costs are for
+	unsigned int capacity;
+	std::vector <State> conflicts;
+	Goal goal;
+	bool built;
+	std::vector <unsigned char> costs;///<learned cost by state
+};
+
+#endif
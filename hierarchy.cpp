@@ -0,0 +1,530 @@
+/**
+ * @file hierarchy.cpp
+ * @brief Preprocessing contraction hierarchies and searching them.
+ */
+
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <functional>
+#include <thread>
+
+#include "hierarchy.h"
+#include "pages.h"
+
+using std::vector;
+
+///@brief First word of a hierarchy file
+static const std::uint32_t HIERARCHY_MAGIC = 0x48435746;//"FWCH" read little endian
+static const std::uint32_t HIERARCHY_VERSION = 2;
+///@brief Words of the header: magic, version, items, capacity, conflicts, states and arcs
+static const std::size_t HIERARCHY_HEADER = 7;
+///@brief States a witness search settles before giving up and letting the shortcut in
+static const unsigned int WITNESS_SETTLE_LIMIT = 16;
+///@brief Priorities are worked out again after a round only if it touched at most this share of the states left
+static const std::size_t EXACT_PRIORITY_SHARE = 4;
+
+///@brief Where a state is in the preprocessing
+enum ContractStatus{
+	CONTRACT_REMAINING,///<still in the graph
+	CONTRACT_ROUND,///<being taken out this round, witness searches go around it
+	CONTRACT_DONE///<taken out, its upward arcs are final
+};
+
+///@brief An arc of the graph being contracted, kept at both ends
+struct ContractEdge{
+	std::uint32_t to;
+	std::uint32_t weight;
+	std::uint32_t middle;///<see ContractionHierarchy::Arc
+};
+
+///@brief A shortcut taking a contracted state's place between two of its neighbours
+struct Shortcut{
+	std::uint32_t from;
+	std::uint32_t to;
+	std::uint32_t weight;
+	std::uint32_t middle;
+};
+
+///@brief A worker's scratch for witness searches
+struct WitnessSearch{
+	vector <std::uint32_t> distance;
+	vector <std::uint32_t> stamp;///<the distance is current if this is the epoch
+	std::uint32_t epoch;
+	vector <std::pair<std::uint32_t, std::uint32_t> > heap;
+
+	WitnessSearch(){
+		epoch = 0;
+	}
+};
+
+///@brief The graph of the states not yet contracted
+struct Contraction{
+	vector <vector <ContractEdge> > graph;
+	vector <unsigned char> status;
+	vector <int> priority;
+	vector <int> shortcuts;///<shortcuts contracting each state would add, when its priority was last worked out
+	vector <int> deleted;///<neighbours contracted so far, spreading contraction over the graph
+};
+
+///@brief Find the shortcuts contracting a state needs, a witness search from each neighbour to the rest
+///@return How many there are
+static unsigned int contract(const Contraction &c, std::uint32_t v, WitnessSearch &witness, vector <Shortcut> * out){
+	const vector <ContractEdge> &edges = c.graph[v];
+	unsigned int rval = 0;
+	if(witness.distance.size() != c.graph.size()){
+		witness.distance.assign(c.graph.size(), 0);
+		witness.stamp.assign(c.graph.size(), 0);
+	}
+	for(std::size_t i = 0; i + 1 < edges.size(); ++i){
+		std::uint32_t farthest = 0;
+		for(std::size_t j = i + 1; j < edges.size(); ++j)
+			farthest = std::max(farthest, edges[j].weight);
+		std::uint32_t limit = edges[i].weight + farthest;
+
+		//Dijkstra from the neighbour up to the longest path through v it has to match
+		if(++witness.epoch == 0){
+			std::fill(witness.stamp.begin(), witness.stamp.end(), 0);
+			witness.epoch = 1;
+		}
+		std::uint32_t source = edges[i].to;
+		witness.distance[source] = 0;
+		witness.stamp[source] = witness.epoch;
+		witness.heap.assign(1, std::make_pair(0u, source));
+		for(unsigned int settled = 0; !witness.heap.empty() and settled < WITNESS_SETTLE_LIMIT; ++settled){
+			std::pop_heap(witness.heap.begin(), witness.heap.end(), std::greater<std::pair<std::uint32_t, std::uint32_t> >());
+			std::uint32_t d = witness.heap.back().first, x = witness.heap.back().second;
+			witness.heap.pop_back();
+			if(d > witness.distance[x])
+				continue;
+			for(std::size_t e = 0; e < c.graph[x].size(); ++e){
+				const ContractEdge &edge = c.graph[x][e];
+				std::uint32_t y = edge.to, reach = d + edge.weight;
+				if(y == v or c.status[y] != CONTRACT_REMAINING or reach > limit)
+					continue;
+				if(witness.stamp[y] != witness.epoch or reach < witness.distance[y]){
+					witness.stamp[y] = witness.epoch;
+					witness.distance[y] = reach;
+					witness.heap.push_back(std::make_pair(reach, y));
+					std::push_heap(witness.heap.begin(), witness.heap.end(), std::greater<std::pair<std::uint32_t, std::uint32_t> >());
+				}
+			}
+		}
+
+		for(std::size_t j = i + 1; j < edges.size(); ++j){
+			std::uint32_t w = edges[j].to, through = edges[i].weight + edges[j].weight;
+			if(witness.stamp[w] == witness.epoch and witness.distance[w] <= through)
+				continue;
+			++rval;
+			if(out != NULL){
+				Shortcut shortcut = {source, w, through, v};
+				out->push_back(shortcut);
+			}
+		}
+	}
+	return rval;
+}
+
+///@brief Contract a slice of a round's states, or with no output only work out their priorities
+///@note Each state's priority is written by the worker given it alone.
+static void contractSlice(Contraction &c, const vector <std::uint32_t> &states, std::size_t begin, std::size_t end,
+		WitnessSearch &witness, vector <Shortcut> * out){
+	for(std::size_t n = begin; n < end; ++n){
+		std::uint32_t v = states[n];
+		int shortcuts = (int)contract(c, v, witness, out);
+		if(out == NULL){
+			c.shortcuts[v] = shortcuts;
+			c.priority[v] = shortcuts - (int)c.graph[v].size() + c.deleted[v];
+		}
+	}
+}
+
+///@brief Run contractSlice() over a list of states split between the workers, the last slice on this thread
+static void contractParallel(Contraction &c, const vector <std::uint32_t> &states, vector <WitnessSearch> &witnesses,
+		vector <vector <Shortcut> > * out){
+	std::size_t threads = witnesses.size(), slice = (states.size() + threads - 1) / threads;
+	vector <std::thread> workers;
+	for(std::size_t t = 0; t < threads; ++t){
+		std::size_t begin = std::min(states.size(), t * slice), end = std::min(states.size(), begin + slice);
+		vector <Shortcut> * shortcuts = out == NULL ? NULL : &(*out)[t];
+		if(t + 1 == threads or end == states.size())
+			contractSlice(c, states, begin, end, witnesses[t], shortcuts);
+		else
+			workers.push_back(std::thread(contractSlice, std::ref(c), std::cref(states), begin, end,
+					std::ref(witnesses[t]), shortcuts));
+		if(end == states.size())
+			break;
+	}
+	for(std::size_t t = 0; t < workers.size(); ++t)
+		workers[t].join();
+}
+
+///@brief Add an arc in one direction, or shorten the one already there
+static void addEdge(vector <ContractEdge> &edges, std::uint32_t to, std::uint32_t weight, std::uint32_t middle){
+	for(std::size_t e = 0; e < edges.size(); ++e){
+		if(edges[e].to == to){
+			if(weight < edges[e].weight){
+				edges[e].weight = weight;
+				edges[e].middle = middle;
+			}
+			return;
+		}
+	}
+	ContractEdge edge = {to, weight, middle};
+	edges.push_back(edge);
+}
+
+ContractionHierarchy::ContractionHierarchy(){
+	items = 0;
+	capacity = 0;
+	built = false;
+	count = 0;
+	stateList = NULL;
+	rankList = NULL;
+	firstArc = NULL;
+	arcList = NULL;
+	mapping = NULL;
+	mappedBytes = 0;
+	epoch = 0;
+}
+
+ContractionHierarchy::~ContractionHierarchy(){
+	release();
+}
+
+void ContractionHierarchy::release(){
+	if(mapping != NULL)
+		unmapFile(mapping, mappedBytes);
+	mapping = NULL;
+	mappedBytes = 0;
+	ownedStates.clear();
+	ownedRanks.clear();
+	ownedFirst.clear();
+	ownedArcs.clear();
+	count = 0;
+	stateList = NULL;
+	rankList = NULL;
+	firstArc = NULL;
+	arcList = NULL;
+	built = false;
+}
+
+bool ContractionHierarchy::prepare(const Puzzle &puzzle, const std::string &path, unsigned int threads){
+	if(built and sameRules(puzzle))
+		return true;
+	release();
+	if(!path.empty() and load(path, puzzle))
+		return true;
+	build(puzzle, threads);
+	return path.empty() or save(path);
+}
+
+std::uint32_t ContractionHierarchy::find(State s)const{
+	const State * at = std::lower_bound(stateList, stateList + count, s);
+	return at == stateList + count or *at != s ? NONE : (std::uint32_t)(at - stateList);
+}
+
+void ContractionHierarchy::build(const Puzzle &puzzle, unsigned int threads){
+	items = (unsigned int)puzzle.items.size();
+	capacity = puzzle.capacity;
+	conflicts = puzzle.conflicts;
+	built = true;
+	if(items > MAX_ITEMS)
+		return;
+
+	for(State s = 0; s <= puzzle.all(); ++s){
+		if(puzzle.legal(s))
+			ownedStates.push_back(s);
+	}
+	count = ownedStates.size();
+	stateList = ownedStates.data();
+	Contraction c;
+	c.graph.resize(count);
+	c.status.assign(count, CONTRACT_REMAINING);
+	c.priority.assign(count, 0);
+	c.shortcuts.assign(count, 0);
+	c.deleted.assign(count, 0);
+	vector <Move> moves;
+	for(std::uint32_t v = 0; v < count; ++v){
+		puzzle.nextMoves(stateList[v], moves);
+		for(std::size_t i = 0; i < moves.size(); ++i){
+			ContractEdge edge = {find(stateList[v] ^ moves[i].carried), 1, NONE};
+			c.graph[v].push_back(edge);
+		}
+	}
+
+	vector <WitnessSearch> witnesses(std::max(threads, 1u));
+	vector <vector <Shortcut> > shortcuts(witnesses.size());
+	vector <std::uint32_t> remaining, round, touched;
+	for(std::uint32_t v = 0; v < count; ++v)
+		remaining.push_back(v);
+	contractParallel(c, remaining, witnesses, NULL);
+	vector <vector <ContractEdge> > upward(count);
+	vector <bool> marked(count, false);
+	ownedRanks.assign(count, 0);
+	for(std::uint32_t rank = 0; !remaining.empty(); ++rank){
+		//the states less important than every neighbour, no two of them neighbours
+		round.clear();
+		for(std::size_t n = 0; n < remaining.size(); ++n){
+			std::uint32_t v = remaining[n];
+			bool least = true;
+			for(std::size_t e = 0; least and e < c.graph[v].size(); ++e){
+				std::uint32_t u = c.graph[v][e].to;
+				least = c.priority[v] < c.priority[u] or (c.priority[v] == c.priority[u] and v < u);
+			}
+			if(least)
+				round.push_back(v);
+		}
+		for(std::size_t n = 0; n < round.size(); ++n)
+			c.status[round[n]] = CONTRACT_ROUND;
+		for(std::size_t t = 0; t < shortcuts.size(); ++t)
+			shortcuts[t].clear();
+		contractParallel(c, round, witnesses, &shortcuts);
+
+		//what is left of each is its arcs to the states still there, then it leaves the graph
+		touched.clear();
+		for(std::size_t n = 0; n < round.size(); ++n){
+			std::uint32_t v = round[n];
+			upward[v] = c.graph[v];
+			ownedRanks[v] = rank;
+			c.status[v] = CONTRACT_DONE;
+			for(std::size_t e = 0; e < c.graph[v].size(); ++e){
+				std::uint32_t u = c.graph[v][e].to;
+				vector <ContractEdge> &back = c.graph[u];
+				for(std::size_t b = 0; b < back.size(); ++b){
+					if(back[b].to == v){
+						back[b] = back.back();
+						back.pop_back();
+						break;
+					}
+				}
+				++c.deleted[u];
+				if(!marked[u]){
+					marked[u] = true;
+					touched.push_back(u);
+				}
+			}
+			vector <ContractEdge>().swap(c.graph[v]);
+		}
+		for(std::size_t t = 0; t < shortcuts.size(); ++t){
+			for(std::size_t i = 0; i < shortcuts[t].size(); ++i){
+				const Shortcut &s = shortcuts[t][i];
+				addEdge(c.graph[s.from], s.to, s.weight, s.middle);
+				addEdge(c.graph[s.to], s.from, s.weight, s.middle);
+			}
+		}
+		for(std::size_t n = 0; n < touched.size(); ++n)
+			marked[touched[n]] = false;
+		//once few states are left they are nearly all touched every round, and working out
+		//their priorities again would cost far more than the better order saves
+		if(touched.size() * EXACT_PRIORITY_SHARE <= remaining.size()){
+			contractParallel(c, touched, witnesses, NULL);
+		}else{
+			for(std::size_t n = 0; n < touched.size(); ++n){
+				std::uint32_t u = touched[n];
+				c.priority[u] = c.shortcuts[u] - (int)c.graph[u].size() + c.deleted[u];
+			}
+		}
+
+		std::size_t kept = 0;
+		for(std::size_t n = 0; n < remaining.size(); ++n){
+			if(c.status[remaining[n]] == CONTRACT_REMAINING)
+				remaining[kept++] = remaining[n];
+		}
+		remaining.resize(kept);
+	}
+
+	ownedFirst.assign(1, 0);
+	for(std::uint32_t v = 0; v < count; ++v){
+		for(std::size_t e = 0; e < upward[v].size(); ++e){
+			Arc arc = {upward[v][e].to, upward[v][e].weight, upward[v][e].middle};
+			ownedArcs.push_back(arc);
+		}
+		ownedFirst.push_back((std::uint32_t)ownedArcs.size());
+	}
+	rankList = ownedRanks.data();
+	firstArc = ownedFirst.data();
+	arcList = ownedArcs.data();
+}
+
+bool ContractionHierarchy::route(State from, State to, vector <Move> &moves, unsigned long &settled){
+	moves.clear();
+	std::uint32_t ends[2] = {find(from), find(to)};
+	if(ends[0] == NONE or ends[1] == NONE)
+		return false;
+	if(ends[0] == ends[1])
+		return true;
+	if(distance[0].size() != count){
+		for(int side = 0; side < 2; ++side){
+			distance[side].assign(count, 0);
+			parent[side].assign(count, (std::uint32_t)NONE);
+			parentArc[side].assign(count, (std::uint32_t)NONE);
+			stamp[side].assign(count, 0);
+		}
+		epoch = 0;
+	}
+	if(++epoch == 0){
+		std::fill(stamp[0].begin(), stamp[0].end(), 0);
+		std::fill(stamp[1].begin(), stamp[1].end(), 0);
+		epoch = 1;
+	}
+	for(int side = 0; side < 2; ++side){
+		distance[side][ends[side]] = 0;
+		parent[side][ends[side]] = NONE;
+		stamp[side][ends[side]] = epoch;
+		queue[side].assign(1, std::make_pair(0u, ends[side]));
+	}
+
+	//upwards from both ends, the side with the nearer state first, until neither can beat the best meeting
+	std::uint32_t best = NONE, meet = NONE;
+	std::greater<std::pair<std::uint32_t, std::uint32_t> > later;
+	for(;;){
+		std::uint32_t next[2];
+		for(int side = 0; side < 2; ++side)
+			next[side] = queue[side].empty() ? NONE : queue[side].front().first;
+		int side = next[0] <= next[1] ? 0 : 1;
+		if(next[side] == NONE or next[side] >= best)
+			break;
+		std::pop_heap(queue[side].begin(), queue[side].end(), later);
+		std::uint32_t d = queue[side].back().first, x = queue[side].back().second;
+		queue[side].pop_back();
+		if(d > distance[side][x])
+			continue;
+		++settled;
+		if(stamp[1 - side][x] == epoch and d + distance[1 - side][x] < best){
+			best = d + distance[1 - side][x];
+			meet = x;
+		}
+		//stall on demand: a more important state reached already has a shorter way down to this one,
+		//so no shortest path goes up through it
+		bool stalled = false;
+		for(std::uint32_t a = firstArc[x]; !stalled and a < firstArc[x + 1]; ++a){
+			std::uint32_t y = arcList[a].to;
+			stalled = stamp[side][y] == epoch and distance[side][y] + arcList[a].weight < d;
+		}
+		for(std::uint32_t a = firstArc[x]; !stalled and a < firstArc[x + 1]; ++a){
+			std::uint32_t y = arcList[a].to, reach = d + arcList[a].weight;
+			if(stamp[side][y] != epoch or reach < distance[side][y]){
+				stamp[side][y] = epoch;
+				distance[side][y] = reach;
+				parent[side][y] = x;
+				parentArc[side][y] = a;
+				queue[side].push_back(std::make_pair(reach, y));
+				std::push_heap(queue[side].begin(), queue[side].end(), later);
+			}
+		}
+	}
+	if(meet == NONE)
+		return false;
+
+	//the arcs from the start up to the meeting state, then down to the goal, each unpacked
+	vector <std::uint32_t> chain;
+	for(std::uint32_t x = meet; x != ends[0]; x = parent[0][x])
+		chain.push_back(x);
+	std::reverse(chain.begin(), chain.end());
+	path.assign(1, from);
+	std::uint32_t at = ends[0];
+	bool whole = true;
+	for(std::size_t i = 0; whole and i < chain.size(); ++i){
+		whole = unpack(at, chain[i], arcList[parentArc[0][chain[i]]].middle);
+		at = chain[i];
+	}
+	for(; whole and at != ends[1]; at = parent[1][at])
+		whole = unpack(at, parent[1][at], arcList[parentArc[1][at]].middle);
+	if(!whole)
+		return false;
+	for(std::size_t i = 1; i < path.size(); ++i)
+		moves.push_back(Move(path[i - 1] ^ path[i], !(path[i - 1] & 1)));
+	return true;
+}
+
+bool ContractionHierarchy::unpack(std::uint32_t from, std::uint32_t to, std::uint32_t middle){
+	if(middle == NONE){
+		path.push_back(stateList[to]);
+		return true;
+	}
+	//the middle state is below both ends, so both halves are among its upward arcs,
+	//and each level down is contracted earlier, so this goes no deeper than the rounds
+	const Arc * halves[2] = {NULL, NULL};
+	for(std::uint32_t a = firstArc[middle]; a < firstArc[middle + 1]; ++a){
+		if(arcList[a].to == from)
+			halves[0] = &arcList[a];
+		else if(arcList[a].to == to)
+			halves[1] = &arcList[a];
+	}
+	if(halves[0] == NULL or halves[1] == NULL)
+		return false;
+	return unpack(from, middle, halves[0]->middle) and unpack(middle, to, halves[1]->middle);
+}
+
+bool ContractionHierarchy::save(const std::string &path)const{
+	//written beside the file and renamed over it, so a reader never maps half a hierarchy
+	std::string temporary = path + ".tmp";
+	std::ofstream out(temporary.c_str(), std::ios::binary | std::ios::trunc);
+	std::uint32_t header[HIERARCHY_HEADER] = {HIERARCHY_MAGIC, HIERARCHY_VERSION, items, capacity,
+			(std::uint32_t)conflicts.size(), (std::uint32_t)count, (std::uint32_t)arcs()};
+	out.write((const char *)header, sizeof(header));
+	for(unsigned int i = 0; i < conflicts.size(); ++i){
+		std::uint32_t conflict = conflicts[i];
+		out.write((const char *)&conflict, sizeof(conflict));
+	}
+	if(count > 0){
+		out.write((const char *)stateList, (std::streamsize)(count * sizeof(State)));
+		out.write((const char *)rankList, (std::streamsize)(count * sizeof(std::uint32_t)));
+		out.write((const char *)firstArc, (std::streamsize)((count + 1) * sizeof(std::uint32_t)));
+		out.write((const char *)arcList, (std::streamsize)(arcs() * sizeof(Arc)));
+	}
+	out.close();
+	if(!out or std::rename(temporary.c_str(), path.c_str()) != 0){
+		std::remove(temporary.c_str());
+		return false;
+	}
+	return true;
+}
+
+bool ContractionHierarchy::load(const std::string &path, const Puzzle &puzzle){
+	std::size_t bytes = 0;
+	const void * file = mapFile(path.c_str(), bytes);
+	if(file == NULL)
+		return false;
+	const std::uint32_t * header = (const std::uint32_t *)file;
+	std::size_t words = bytes / 4;
+	bool good = bytes % 4 == 0 and words >= HIERARCHY_HEADER and header[0] == HIERARCHY_MAGIC and header[1] == HIERARCHY_VERSION
+			and header[2] == puzzle.items.size() and header[2] <= MAX_ITEMS and header[3] == puzzle.capacity
+			and header[4] == puzzle.conflicts.size() and words >= HIERARCHY_HEADER + header[4];
+	for(unsigned int i = 0; good and i < header[4]; ++i)
+		good = header[HIERARCHY_HEADER + i] == puzzle.conflicts[i];
+	const std::uint32_t * body = header + HIERARCHY_HEADER + (good ? header[4] : 0);
+	std::size_t states = good ? header[5] : 0, arcCount = good ? header[6] : 0;
+	good = good and words == HIERARCHY_HEADER + header[4] + 2 * states + (states > 0 ? states + 1 : 0) + 3 * arcCount;
+	//every index in range, so a damaged file can't send a search outside the mapping
+	const std::uint32_t * ranks = body + states;
+	const std::uint32_t * first = ranks + states;
+	const Arc * arcs = (const Arc *)(first + states + 1);
+	for(std::size_t v = 0; good and v < states; ++v)
+		good = first[v] <= first[v + 1] and (v == 0 or body[v - 1] < body[v]);
+	good = good and (states == 0 or (first[0] == 0 and first[states] == arcCount));
+	for(std::size_t a = 0; good and a < arcCount; ++a)
+		good = arcs[a].to < states and (arcs[a].middle < states or arcs[a].middle == NONE);
+	//and every arc upwards with its middle state below it, so unpacking a shortcut can't go round in circles
+	for(std::size_t v = 0; good and v < states; ++v){
+		for(std::uint32_t a = first[v]; good and a < first[v + 1]; ++a)
+			good = ranks[v] < ranks[arcs[a].to] and (arcs[a].middle == NONE or ranks[arcs[a].middle] < ranks[v]);
+	}
+	if(!good){
+		unmapFile(file, bytes);
+		return false;
+	}
+	items = (unsigned int)puzzle.items.size();
+	capacity = puzzle.capacity;
+	conflicts = puzzle.conflicts;
+	built = true;
+	count = states;
+	stateList = body;
+	rankList = states > 0 ? ranks : NULL;
+	firstArc = states > 0 ? first : NULL;
+	arcList = states > 0 ? arcs : NULL;
+	mapping = file;
+	mappedBytes = bytes;
+	return true;
+}
@@ -0,0 +1,134 @@
+/**
+ * @file hierarchy.h
+ * @brief Contraction hierarchies over the whole state graph of a puzzle.
+ */
+
+#ifndef FWDC_HIERARCHY_H
+#define FWDC_HIERARCHY_H
+
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "puzzle.h"
+
+/**
+ * @brief Shortest paths between any two states by a search of a contraction hierarchy
+ *
+ * Preprocessing takes the legal states one at a time, least important first, out
+ * of the graph of crossings, adding a shortcut between two of its neighbours
+ * wherever the only shortest path between them went through it. Importance is
+ * the shortcuts a state would add less the arcs it removes, plus the neighbours
+ * already taken out, so states whose removal keeps the graph small go first.
+ * States no two of which are neighbours are taken out together, each round split
+ * between threads, with witness searches avoiding all of them. Once each round
+ * touches most of the states left, their priorities are updated from the
+ * shortcut counts last worked out rather than by searching again.
+ *
+ * What is left is the arcs from each state to more important ones. A query is a
+ * Dijkstra search upwards from both ends, which meet at the most important state
+ * of a shortest path, and the shortcuts along it are unpacked into crossings.
+ * Crossings can always be undone, so one set of upward arcs serves both ends.
+ * The hierarchy can be saved to a file that later runs map instead of rebuilding.
+ *
+ * Items in no conflict make the graph close to a hypercube, which no order
+ * contracts well, so hierarchies pay off most where conflicts thin the graph out.
+ */
+class ContractionHierarchy{
+public:
+	static const unsigned int MAX_ITEMS = 16;///<preprocessing sixty thousand states can take minutes
+	static const std::uint32_t NONE = 0xffffffff;///<middle state of an arc that is a crossing, not a shortcut
+
+	ContractionHierarchy();
+	~ContractionHierarchy();
+
+	///@brief Get the hierarchy for a puzzle, unless it is for it already
+	///@param puzzle The puzzle, with no hierarchy and route() always failing above MAX_ITEMS items
+	///@param path File to map the hierarchy from, or to save it to if it doesn't hold one for this
+	///	puzzle; empty to keep it in memory only
+	///@param threads Threads to preprocess with
+	///@return False if the file could not be written, the hierarchy is in memory all the same
+	bool prepare(const Puzzle &puzzle, const std::string &path, unsigned int threads);
+
+	///@brief Find a shortest path between two legal states
+	///@param from The state to start from
+	///@param to The state to reach
+	///@param moves Cleared and filled with the moves of the path
+	///@param settled Increased by the states the search settled
+	///@return False if there is no path, either state is illegal, or a shortcut can't be unpacked
+	bool route(State from, State to, std::vector <Move> &moves, unsigned long &settled);
+
+	///@brief Legal states in the hierarchy
+	std::size_t states()const{
+		return count;
+	}
+
+	///@brief Upward arcs, crossings and shortcuts
+	std::size_t arcs()const{
+		return count == 0 ? 0 : firstArc[count];
+	}
+
+	///@brief Are the arcs mapped from a file rather than built in memory?
+	bool mapped()const{
+		return mapping != NULL;
+	}
+
+	///@brief Write the hierarchy to a file, replacing it
+	bool save(const std::string &path)const;
+
+	///@brief Map the hierarchy from a file, if it holds one for a puzzle
+	bool load(const std::string &path, const Puzzle &puzzle);
+
+private:
+	///@brief An arc to a more important state
+	struct Arc{
+		std::uint32_t to;///<the state it leads to, by index
+		std::uint32_t weight;///<crossings it stands for
+		std::uint32_t middle;///<the state it was contracted through, NONE for a crossing
+	};
+
+	unsigned int items;///<the puzzle the hierarchy is for
+	unsigned int capacity;
+	std::vector <State> conflicts;
+	bool built;
+	std::size_t count;
+	const State * stateList;///<the legal states in increasing order, each indexed by its position
+	const std::uint32_t * rankList;///<the round each state was contracted in, lower than those of its arcs
+	const std::uint32_t * firstArc;///<first upward arc of each state, and the end of the last
+	const Arc * arcList;
+	std::vector <State> ownedStates;///<what the pointers point into unless the hierarchy is mapped
+	std::vector <std::uint32_t> ownedRanks;
+	std::vector <std::uint32_t> ownedFirst;
+	std::vector <Arc> ownedArcs;
+	const void * mapping;
+	std::size_t mappedBytes;
+
+	//scratch for route(), a side for each end of the search
+	std::vector <std::uint32_t> distance[2];
+	std::vector <std::uint32_t> parent[2];///<the state each was reached from
+	std::vector <std::uint32_t> parentArc[2];///<and the arc it was reached by
+	std::vector <std::uint32_t> stamp[2];///<the distance is current if this is the epoch
+	std::vector <std::pair<std::uint32_t, std::uint32_t> > queue[2];///<heaps of distance and state
+	std::vector <State> path;
+	std::uint32_t epoch;
+
+	ContractionHierarchy(const ContractionHierarchy &);
+	ContractionHierarchy &operator=(const ContractionHierarchy &);
+
+	bool sameRules(const Puzzle &puzzle)const{
+		return items == puzzle.items.size() and capacity == puzzle.capacity and conflicts == puzzle.conflicts;
+	}
+
+	///@brief Index of a legal state, NONE if it isn't one
+	std::uint32_t find(State s)const;
+
+	///@brief Append the states after from up to to along an arc, replacing shortcuts by their crossings
+	///@return False if a shortcut's middle state lacks an arc to either end
+	bool unpack(std::uint32_t from, std::uint32_t to, std::uint32_t middle);
+
+	void build(const Puzzle &puzzle, unsigned int threads);
+	void release();
+};
+
+#endif
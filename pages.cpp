@@ -0,0 +1,113 @@
+/**
+ * @file pages.cpp
+ * @brief Mapping memory with huge pages.
+ */
+
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+
+#include "pages.h"
+
+#if defined(__linux__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+static std::atomic <unsigned long> fallbacks[3];
+
+///@brief Round up to a whole number of huge pages, which explicit mappings need
+static std::size_t roundUp(std::size_t bytes){
+	return (bytes + HUGE_PAGE_SIZE - 1) / HUGE_PAGE_SIZE * HUGE_PAGE_SIZE;
+}
+
+void * mapPages(std::size_t bytes, HugePages policy){
+	bytes = roundUp(bytes);
+#if defined(__linux__)
+#ifdef MAP_HUGETLB
+	if(policy == HUGE_PAGES_EXPLICIT){
+		void * rval = mmap(NULL, bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+		if(rval != MAP_FAILED)
+			return rval;
+		//no reserved huge pages, try for transparent ones instead
+		++fallbacks[policy];
+	}
+#endif
+	void * rval = mmap(NULL, bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+	if(rval == MAP_FAILED)
+		return NULL;
+#ifdef MADV_HUGEPAGE
+	if(madvise(rval, bytes, MADV_HUGEPAGE) != 0)
+		++fallbacks[HUGE_PAGES_TRANSPARENT];
+#endif
+	return rval;
+#else
+	//no huge pages here, plain memory of the same rounded size
+	++fallbacks[policy];
+	return std::malloc(bytes);
+#endif
+}
+
+void unmapPages(void * address, std::size_t bytes){
+#if defined(__linux__)
+	munmap(address, roundUp(bytes));
+#else
+	(void)bytes;
+	std::free(address);
+#endif
+}
+
+unsigned long hugePageFallbacks(HugePages policy){
+	return fallbacks[policy];
+}
+
+const void * mapFile(const char * path, std::size_t &bytes){
+	bytes = 0;
+#if defined(__linux__)
+	int fd = open(path, O_RDONLY);
+	if(fd < 0)
+		return NULL;
+	struct stat status;
+	void * rval = NULL;
+	if(fstat(fd, &status) == 0 and status.st_size > 0){
+		rval = mmap(NULL, (std::size_t)status.st_size, PROT_READ, MAP_SHARED, fd, 0);
+		if(rval == MAP_FAILED)
+			rval = NULL;
+		else
+			bytes = (std::size_t)status.st_size;
+	}
+	//the mapping keeps the file open
+	close(fd);
+	return rval;
+#else
+	//no mapping here, read the file into memory
+	std::FILE * file = std::fopen(path, "rb");
+	if(file == NULL)
+		return NULL;
+	char * rval = NULL;
+	if(std::fseek(file, 0, SEEK_END) == 0){
+		long size = std::ftell(file);
+		if(size > 0 and std::fseek(file, 0, SEEK_SET) == 0 and (rval = (char *)std::malloc((std::size_t)size)) != NULL){
+			if(std::fread(rval, 1, (std::size_t)size, file) == (std::size_t)size){
+				bytes = (std::size_t)size;
+			}else{
+				std::free(rval);
+				rval = NULL;
+			}
+		}
+	}
+	std::fclose(file);
+	return rval;
+#endif
+}
+
+void unmapFile(const void * address, std::size_t bytes){
+#if defined(__linux__)
+	munmap(const_cast<void *>(address), bytes);
+#else
+	(void)bytes;
+	std::free(const_cast<void *>(address));
+#endif
+}
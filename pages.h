@@ -0,0 +1,105 @@
+/**
+ * @file pages.h
+ * @brief Memory for the large tables of a search, optionally backed by huge pages or a file.
+ */
+
+#ifndef FWDC_PAGES_H
+#define FWDC_PAGES_H
+
+#include <cstddef>
+#include <new>
+#include <type_traits>
+
+///@brief How large allocations ask the operating system for huge pages
+enum HugePages{
+	HUGE_PAGES_OFF,///<ordinary heap memory
+	HUGE_PAGES_TRANSPARENT,///<mapped memory advised to use transparent huge pages
+	HUGE_PAGES_EXPLICIT///<mapped from the reserved huge page pool, falling back to TRANSPARENT if it is empty
+};
+
+///@brief Allocations from this size up are mapped page by page when huge pages are wanted
+static const std::size_t HUGE_PAGE_SIZE = (std::size_t)2 << 20;
+
+///@brief Map memory for an allocation of at least HUGE_PAGE_SIZE bytes
+///@return The memory, or NULL if the system has none to map
+void * mapPages(std::size_t bytes, HugePages policy);
+
+///@brief Unmap memory returned by mapPages() for the same number of bytes
+void unmapPages(void * address, std::size_t bytes);
+
+///@brief Number of mapPages() calls whose huge page request the system refused, by policy
+unsigned long hugePageFallbacks(HugePages policy);
+
+///@brief Map a whole file read only, so its pages load as they are used and are shared between processes
+///@param bytes Set to the size of the file
+///@return Its contents, or NULL if it can't be read or is empty
+const void * mapFile(const char * path, std::size_t &bytes);
+
+///@brief Unmap a file mapped by mapFile()
+void unmapFile(const void * address, std::size_t bytes);
+
+/**
+ * @brief Standard allocator that maps large blocks with huge pages
+ *
+ * Blocks smaller than HUGE_PAGE_SIZE, and every block when the policy is off,
+ * come from operator new. Containers take the allocator's policy along when
+ * they are moved or swapped, so a table can grow by swapping in a new vector.
+ */
+template <class T>
+class PageAllocator{
+public:
+	typedef T value_type;
+	typedef std::true_type propagate_on_container_move_assignment;
+	typedef std::true_type propagate_on_container_swap;
+
+	HugePages policy;
+
+	PageAllocator(HugePages hugePages = HUGE_PAGES_OFF){
+		policy = hugePages;
+	}
+
+	template <class U>
+	PageAllocator(const PageAllocator <U> &other){
+		policy = other.policy;
+	}
+
+	T * allocate(std::size_t n){
+		std::size_t bytes = n * sizeof(T);
+		if(!mapped(bytes)){
+			if(alignof(T) > __STDCPP_DEFAULT_NEW_ALIGNMENT__)
+				return static_cast<T *>(::operator new(bytes, std::align_val_t(alignof(T))));
+			return static_cast<T *>(::operator new(bytes));
+		}
+		void * rval = mapPages(bytes, policy);
+		if(rval == NULL)
+			throw std::bad_alloc();
+		return static_cast<T *>(rval);
+	}
+
+	void deallocate(T * p, std::size_t n){
+		std::size_t bytes = n * sizeof(T);
+		if(mapped(bytes))
+			unmapPages(p, bytes);
+		else if(alignof(T) > __STDCPP_DEFAULT_NEW_ALIGNMENT__)
+			::operator delete(p, std::align_val_t(alignof(T)));
+		else
+			::operator delete(p);
+	}
+
+	template <class U>
+	bool operator==(const PageAllocator <U> &other)const{
+		return policy == other.policy;
+	}
+
+	template <class U>
+	bool operator!=(const PageAllocator <U> &other)const{
+		return policy != other.policy;
+	}
+
+private:
+	bool mapped(std::size_t bytes)const{
+		return policy != HUGE_PAGES_OFF and bytes >= HUGE_PAGE_SIZE;
+	}
+};
+
+#endif
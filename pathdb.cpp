@@ -0,0 +1,144 @@
+/**
+ * @file pathdb.cpp
+ * @brief Building compressed path databases.
+ */
+
+#include <algorithm>
+
+#include "bitmap.h"
+#include "pathdb.h"
+
+using std::vector;
+
+bool PathDatabase::prepare(const Puzzle &puzzle){
+	if(!built or items != puzzle.items.size() or capacity != puzzle.capacity or conflicts != puzzle.conflicts)
+		build(puzzle);
+	return items <= MAX_ITEMS;
+}
+
+void PathDatabase::build(const Puzzle &puzzle){
+	items = (unsigned int)puzzle.items.size();
+	capacity = puzzle.capacity;
+	conflicts = puzzle.conflicts;
+	built = true;
+	loads.clear();
+	ranks.clear();
+	order.clear();
+	components.clear();
+	rows.clear();
+	runs.clear();
+	if(items > MAX_ITEMS)
+		return;
+	loads = puzzle.loads;
+
+	//the legal states depth first, a whole connected component at a time
+	State states = (State)1 << items;
+	ranks.assign(states, (std::uint32_t)UNRANKED);
+	vector <State> stack;
+	vector <Move> moves;
+	for(State root = 0; root < states; ++root){
+		if(ranks[root] != UNRANKED or !puzzle.legal(root))
+			continue;
+		components.push_back((std::uint32_t)order.size());
+		stack.push_back(root);
+		while(!stack.empty()){
+			State s = stack.back();
+			stack.pop_back();
+			if(ranks[s] != UNRANKED)
+				continue;
+			ranks[s] = (std::uint32_t)order.size();
+			order.push_back(s);
+			puzzle.nextMoves(s, moves);
+			for(unsigned int i = moves.size(); i-- > 0;){
+				if(ranks[s ^ moves[i].carried] == UNRANKED)
+					stack.push_back(s ^ moves[i].carried);
+			}
+		}
+	}
+
+	components.push_back((std::uint32_t)order.size());
+
+	//the moves between legal states by rank, with the index of each load
+	std::uint32_t count = (std::uint32_t)order.size();
+	vector <std::uint32_t> edgeBegin(count + 1, 0), edgeTarget, edgeLoad;
+	for(std::uint32_t r = 0; r < count; ++r){
+		State s = order[r];
+		State side = (s & 1) ? s : ~s & puzzle.all();
+		for(unsigned int i = 0; i < loads.size(); ++i){
+			if((loads[i] & side) == loads[i] and puzzle.legal(s ^ loads[i])){
+				edgeTarget.push_back(ranks[s ^ loads[i]]);
+				edgeLoad.push_back(i);
+			}
+		}
+		edgeBegin[r + 1] = (std::uint32_t)edgeTarget.size();
+	}
+
+	vector <std::uint32_t> seen(count, (std::uint32_t)UNRANKED), depth(count), queue;
+	vector <std::uint64_t> optimal, common;
+	queue.reserve(count);
+	for(unsigned int c = 0; c + 1 < components.size(); ++c){
+		std::uint32_t begin = components[c], end = components[c + 1];
+		for(std::uint32_t source = begin; source < end; ++source){
+			//breadth first from the source, keeping for each state the set of first moves
+			//starting an optimal path to it, a bit per move of the source
+			std::size_t words = (edgeBegin[source + 1] - edgeBegin[source] + 63) / 64;
+			optimal.resize(count * words);
+			queue.clear();
+			seen[source] = source;
+			for(std::uint32_t e = edgeBegin[source]; e < edgeBegin[source + 1]; ++e){
+				std::uint32_t child = edgeTarget[e], bit = e - edgeBegin[source];
+				seen[child] = source;
+				depth[child] = 1;
+				std::fill(optimal.begin() + child * words, optimal.begin() + (child + 1) * words, 0);
+				optimal[child * words + bit / 64] |= (std::uint64_t)1 << bit % 64;
+				queue.push_back(child);
+			}
+			for(std::size_t q = 0; q < queue.size(); ++q){
+				std::uint32_t r = queue[q];
+				for(std::uint32_t e = edgeBegin[r]; e < edgeBegin[r + 1]; ++e){
+					std::uint32_t child = edgeTarget[e];
+					if(seen[child] != source){
+						seen[child] = source;
+						depth[child] = depth[r] + 1;
+						std::copy(optimal.begin() + r * words, optimal.begin() + (r + 1) * words, optimal.begin() + child * words);
+						queue.push_back(child);
+					}else if(depth[child] == depth[r] + 1){
+						for(std::size_t w = 0; w < words; ++w)
+							optimal[child * words + w] |= optimal[r * words + w];
+					}
+				}
+			}
+
+			//greedily make each run as long as some move is optimal for all of it, the source fits any run
+			rows.push_back((std::uint32_t)runs.size());
+			std::uint32_t start = begin;
+			bool open = false;
+			for(std::uint32_t target = begin; target <= end; ++target){
+				if(target == source)
+					continue;
+				const std::uint64_t * moves = target < end ? &optimal[target * words] : NULL;
+				bool shared = false;
+				for(std::size_t w = 0; open and moves != NULL and w < words; ++w)
+					shared = shared or (common[w] & moves[w]) != 0;
+				if(open and shared){
+					for(std::size_t w = 0; w < words; ++w)
+						common[w] &= moves[w];
+					continue;
+				}
+				if(open){
+					std::size_t w = 0;
+					while(common[w] == 0)
+						++w;
+					std::uint32_t bit = (std::uint32_t)(w * 64 + StateBitmap::lowestBit(common[w]));
+					runs.push_back(start << 16 | edgeLoad[edgeBegin[source] + bit]);
+					start = target;
+				}
+				if(moves != NULL){
+					common.assign(moves, moves + words);
+					open = true;
+				}
+			}
+		}
+	}
+	rows.push_back((std::uint32_t)runs.size());
+}
@@ -0,0 +1,96 @@
+/**
+ * @file pathdb.h
+ * @brief Compressed path databases, the first optimal move from any state to any other.
+ */
+
+#ifndef FWDC_PATHDB_H
+#define FWDC_PATHDB_H
+
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+#include "puzzle.h"
+
+/**
+ * @brief The first move of an optimal path between every pair of legal states
+ *
+ * Each source state has a row holding the boat load of a first optimal move
+ * towards every target, run length encoded over an ordering of the states. The
+ * ordering is depth first from state to neighbouring state, so targets next to
+ * each other in it tend to lie the same way from a source. Where several first
+ * moves are optimal for a target any of them will do, and each run is made as
+ * long as some move stays optimal for all of its targets; targets in another
+ * connected component need no entry at all. A row ends up with far fewer runs
+ * than states, and answering a query is a binary search of one row.
+ *
+ * The database is built by a breadth first search from every legal state, so
+ * the time it takes grows with the square of the number of states; it is meant
+ * for puzzles queried many times, and kept until the puzzle changes.
+ */
+class PathDatabase{
+public:
+	static const unsigned int MAX_ITEMS = 14;///<at most 16384 states, building takes time quadratic in them
+	static const std::uint32_t UNRANKED = 0xffffffff;///<rank of an illegal state, it is no source or target
+	static const std::uint32_t LOAD_MASK = 0xffff;///<bits of a run giving its load, the rest give the rank it starts at
+
+	PathDatabase(){
+		items = 0;
+		capacity = 0;
+		built = false;
+	}
+
+	///@brief Build the database for a puzzle, unless it was built for it last
+	///@return False if the puzzle has more than MAX_ITEMS items, next() then finds no moves
+	bool prepare(const Puzzle &puzzle);
+
+	///@brief The first move of an optimal path from one legal state to another
+	///@return False if there is none: the states are the same, illegal or not connected
+	bool next(State from, State to, Move &move)const{
+		if(from >= ranks.size() or to >= ranks.size())
+			return false;
+		std::uint32_t source = ranks[from], target = ranks[to];
+		if(source == UNRANKED or target == UNRANKED or source == target)
+			return false;
+		//a row covers the source's component, from its first state to the next component's
+		std::size_t component = std::upper_bound(components.begin(), components.end(), source) - components.begin();
+		if(target < components[component - 1] or target >= components[component])
+			return false;
+		//the last run starting at or before the target
+		const std::uint32_t * first = runs.data() + rows[source], * last = runs.data() + rows[source + 1];
+		const std::uint32_t * run = std::upper_bound(first, last, target << 16 | LOAD_MASK);
+		move = Move(loads[run[-1] & LOAD_MASK], !(from & 1));
+		return true;
+	}
+
+	///@brief Legal states, the sources and targets of the database
+	std::size_t states()const{
+		return order.size();
+	}
+
+	///@brief Runs over every row
+	std::size_t runCount()const{
+		return runs.size();
+	}
+
+	///@brief Memory taken by the database
+	std::size_t bytes()const{
+		return 4 * (ranks.size() + order.size() + components.size() + rows.size() + runs.size() + loads.size());
+	}
+
+private:
+	unsigned int items;///<the puzzle the database is for
+	unsigned int capacity;
+	std::vector <State> conflicts;
+	bool built;
+	std::vector <State> loads;///<Puzzle::loads, the runs name a load by its index here
+	std::vector <std::uint32_t> ranks;///<position of each state in the ordering, UNRANKED if illegal
+	std::vector <State> order;///<the legal states in order
+	std::vector <std::uint32_t> components;///<rank of the first state of each connected component, and the number of states
+	std::vector <std::uint32_t> rows;///<first run of each source by rank, and the end of the last
+	std::vector <std::uint32_t> runs;///<target rank the run starts at in the high 16 bits, load index in the low 16
+
+	void build(const Puzzle &puzzle);
+};
+
+#endif
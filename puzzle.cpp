@@ -0,0 +1,287 @@
+/**
+ * @file puzzle.cpp
+ * @brief Loading puzzle definitions and queries.
+ */
+
+#include <fstream>
+#include <sstream>
+
+#include "puzzle.h"
+
+using std::string;
+using std::vector;
+
+static bool parseUnsigned(const string &text, unsigned int &value){
+	std::from_chars_result r = std::from_chars(text.data(), text.data() + text.size(), value);
+	return r.ec == std::errc() and r.ptr == text.data() + text.size();
+}
+
+bool Puzzle::load(const char * first, const char * last, string &error){
+	Puzzle rval;
+	rval.items.clear();
+	rval.conflicts.clear();
+	bool haveStart = false, haveGoal = false;
+	string startText, goalText;
+	vector <std::pair<string, string> > pairs;
+	vector <vector <string> > declared;
+	int line = 0;
+	while(first != last){
+		const char * end = std::find(first, last, '\n');
+		string text(first, end);
+		first = end == last ? last : end + 1;
+		++line;
+		string::size_type hash = text.find('#');
+		if(hash != string::npos)
+			text.erase(hash);
+		std::istringstream in(text);
+		vector <string> tokens;
+		string token;
+		while(in >> token)
+			tokens.push_back(token);
+		if(tokens.empty())
+			continue;
+
+		std::ostringstream where;
+		where << "line " << line << ": ";
+		if(tokens[0] == "items"){
+			if(!rval.items.empty() or tokens.size() < 2){
+				error = where.str() + "expected a single 'items' line naming at least the farmer";
+				return false;
+			}
+			rval.items.assign(tokens.begin() + 1, tokens.end());
+		}else if(tokens[0] == "capacity"){
+			unsigned int value = 0;
+			if(tokens.size() != 2 or !parseUnsigned(tokens[1], value) or value == 0){
+				error = where.str() + "capacity must be a positive number";
+				return false;
+			}
+			rval.capacity = value;
+		}else if(tokens[0] == "conflict"){
+			if(tokens.size() != 3){
+				error = where.str() + "a conflict names exactly two items";
+				return false;
+			}
+			pairs.push_back(std::make_pair(tokens[1], tokens[2]));
+		}else if(tokens[0] == "invariant"){
+			if(tokens.size() < 2){
+				error = where.str() + "an invariant names at least one item";
+				return false;
+			}
+			declared.push_back(vector <string>(tokens.begin() + 1, tokens.end()));
+		}else if(tokens[0] == "start" and tokens.size() == 2 and !haveStart){
+			startText = tokens[1];
+			haveStart = true;
+		}else if(tokens[0] == "goal" and tokens.size() == 2 and !haveGoal){
+			goalText = tokens[1];
+			haveGoal = true;
+		}else{
+			error = where.str() + "unexpected '" + tokens[0] + "'";
+			return false;
+		}
+	}
+
+	if(rval.items.empty()){
+		error = "no items declared";
+		return false;
+	}
+	if(rval.items.size() > MAX_ITEMS){
+		error = "too many items";
+		return false;
+	}
+	for(unsigned int i = 0; i < rval.items.size(); ++i){
+		if(rval.items[i].size() > MAX_NAME or rval.items[i].find_first_of("[]|,\"\\") != string::npos){
+			error = "bad item name '" + rval.items[i] + "'";
+			return false;
+		}
+		for(unsigned int j = 0; j < i; ++j){
+			if(rval.items[i] == rval.items[j]){
+				error = "item '" + rval.items[i] + "' declared twice";
+				return false;
+			}
+		}
+	}
+	for(unsigned int i = 0; i < pairs.size(); ++i){
+		int a = rval.find(pairs[i].first), b = rval.find(pairs[i].second);
+		if(a < 0 or b < 0 or a == b or a == 0 or b == 0){
+			error = "bad conflict between '" + pairs[i].first + "' and '" + pairs[i].second + "'";
+			return false;
+		}
+		rval.conflicts.push_back(1u << a | 1u << b);
+	}
+	if(!rval.buildTables()){
+		error = "too many different boat loads";
+		return false;
+	}
+	for(unsigned int i = 0; i < declared.size(); ++i){
+		State mask = 0;
+		for(unsigned int j = 0; j < declared[i].size(); ++j){
+			int item = rval.find(declared[i][j]);
+			if(item < 0 or (mask & 1u << item)){
+				error = "bad invariant item '" + declared[i][j] + "'";
+				return false;
+			}
+			mask |= 1u << item;
+		}
+		for(unsigned int j = 0; j < rval.loads.size(); ++j){
+			if(countItems(rval.loads[j] & mask) % 2 == 0){
+				error = "invariant '" + declared[i][0] + "...' doesn't hold, the boat can carry an even number of its items";
+				return false;
+			}
+		}
+		if(std::find(rval.invariants.begin(), rval.invariants.end(), mask) == rval.invariants.end())
+			rval.invariants.push_back(mask);
+	}
+	rval.start = 0;
+	rval.goal = rval.all();
+	if((haveStart and !rval.parse(startText, rval.start)) or !rval.legal(rval.start)){
+		error = "bad start state '" + startText + "'";
+		return false;
+	}
+	if((haveGoal and !rval.parse(goalText, rval.goal)) or !rval.legal(rval.goal)){
+		error = "bad goal state '" + goalText + "'";
+		return false;
+	}
+	*this = rval;
+	return true;
+}
+
+bool Puzzle::loadFile(const string &path, string &error){
+	std::ifstream in(path.c_str(), std::ios::binary);
+	if(!in){
+		error = "can't open '" + path + "'";
+		return false;
+	}
+	std::ostringstream text;
+	text << in.rdbuf();
+	string contents = text.str();
+	if(!load(contents.data(), contents.data() + contents.size(), error)){
+		error = path + ": " + error;
+		return false;
+	}
+	return true;
+}
+
+bool Puzzle::addLoads(State load, unsigned int from, unsigned int count){
+	if(count == 0){
+		loads.push_back(load);
+		return loads.size() <= MAX_LOADS;
+	}
+	for(unsigned int i = from; i + count <= items.size(); ++i){
+		if(!addLoads(load | 1u << i, i + 1, count - 1))
+			return false;
+	}
+	return true;
+}
+
+bool Puzzle::buildTables(){
+	namePointers.clear();
+	nameLengths.clear();
+	bool single = true;
+	longest = 4 + (unsigned int)items.size();
+	for(unsigned int i = 0; i < items.size(); ++i){
+		longest += (unsigned int)items[i].size();
+		namePointers.push_back(items[i].c_str());
+		nameLengths.push_back((unsigned char)items[i].size());
+		single = single and items[i].size() == 1;
+	}
+	names.names = namePointers.empty() ? NULL : &namePointers[0];
+	names.lengths = nameLengths.empty() ? NULL : &nameLengths[0];
+	names.count = (unsigned int)items.size();
+	names.separator = single ? 0 : ',';
+
+	loads.clear();
+	for(unsigned int count = 0; count <= capacity and count < items.size(); ++count){
+		if(!addLoads(1, 1, count))
+			return false;
+	}
+	return true;
+}
+
+///@brief Builds the loads taking set numbers of passengers from up to three groups of items
+struct LoadBuilder{
+	const Puzzle * puzzle;
+	State s;///<state moved from
+	State groups[3];///<items the passengers are taken from
+	int counts[3];///<passengers taken from each group
+	vector <Move> * out;
+
+	///@brief Add the legal moves carrying the passengers still to choose on top of load
+	///@param group The group being chosen from
+	///@param load The farmer and the passengers chosen so far
+	///@param remaining The items of the group that may still be chosen
+	///@param count How many more to choose from the group
+	void build(int group, State load, State remaining, int count){
+		if(count == 0){
+			if(group < 2)
+				build(group + 1, load, groups[group + 1], counts[group + 1]);
+			else if(puzzle->legal(s ^ load))
+				out->push_back(Move(load, !(s & 1)));
+			return;
+		}
+		for(State left = remaining; countItems(left) >= count;){
+			State item = left & (~left + 1);
+			left &= left - 1;
+			build(group, load | item, left, count - 1);
+		}
+	}
+};
+
+int Puzzle::partialMoves(State s, const Goal &target, int delta, vector <Move> &out)const{
+	out.clear();
+	State side = (s & 1) ? s : ~s & all();
+	State wrong = (s ^ target.state) & target.mask & ~1u;
+	int count = countItems(wrong);
+	int cap = (int)capacity;
+	int before = (count + cap - 1) / cap;
+	LoadBuilder builder = {this, s, {wrong & side, target.mask & ~wrong & side & ~1u, ~target.mask & side & ~1u}, {0, 0, 0}, &out};
+	int available[3] = {countItems(builder.groups[0]), countItems(builder.groups[1]), countItems(builder.groups[2])};
+	int later = -1;
+	//carrying a wrong items and b right ones leaves count - a + b wrong
+	for(int a = 0; a <= available[0] and a <= cap; ++a){
+		for(int b = 0; b <= available[1] and a + b <= cap; ++b){
+			int increase = 1 + (count - a + b + cap - 1) / cap - before;
+			if(increase > delta and (later < 0 or increase < later))
+				later = increase;
+			if(increase != delta)
+				continue;
+			for(int c = 0; c <= available[2] and a + b + c <= cap; ++c){
+				builder.counts[0] = a;
+				builder.counts[1] = b;
+				builder.counts[2] = c;
+				builder.build(0, 1, builder.groups[0], a);
+			}
+		}
+	}
+	return later;
+}
+
+bool parseQuery(const Puzzle &puzzle, const char * first, const char * last, State &start, Goal &goal){
+	const char * token[2] = {NULL, NULL};
+	const char * end[2] = {NULL, NULL};
+	int count = 0;
+	while(first != last){
+		if(*first == ' ' or *first == '\t' or *first == '\r'){
+			++first;
+			continue;
+		}
+		if(count == 2)
+			return false;
+		token[count] = first;
+		while(first != last and *first != ' ' and *first != '\t' and *first != '\r')
+			++first;
+		end[count++] = first;
+	}
+	if(count == 0)
+		return false;
+	State states[2] = {puzzle.start, puzzle.goal};
+	for(int i = 0; i < count; ++i){
+		if(end[i] - token[i] == 1 and *token[i] == '-')
+			continue;
+		std::from_chars_result r = puzzle.parse(token[i], end[i], states[i]);
+		if(r.ec != std::errc() or r.ptr != end[i])
+			return false;
+	}
+	start = states[0];
+	goal = Goal(states[1], puzzle.all());
+	return true;
+}
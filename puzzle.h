@@ -0,0 +1,428 @@
+/**
+ * @file puzzle.h
+ * @brief Generalized river crossing puzzles, goals and encoded solution paths.
+ */
+
+#ifndef FWDC_PUZZLE_H
+#define FWDC_PUZZLE_H
+
+#include <algorithm>
+#include <ostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "state.h"
+
+/**
+ * @brief The states a search is trying to reach
+ */
+struct Goal{
+	State state;///<the bank each item has to be on
+	State mask;///<the items whose bank matters
+
+	///@brief Construct a goal requiring the items in mask to be on the banks given by state
+	Goal(State goalState = 0, State goalMask = 0){
+		state = goalState;
+		mask = goalMask;
+	}
+
+	///@brief Does a state satisfy the goal?
+	bool matches(State s)const{
+		return ((s ^ state) & mask) == 0;
+	}
+};
+
+/**
+ * @brief A generalized river crossing puzzle
+ *
+ * Item 0 is the farmer, the only one who can row. The boat carries the farmer and
+ * up to capacity other items, and a conflicting pair may never be left together
+ * on a bank without the farmer. The default puzzle is the farmer, wolf, duck and
+ * corn with room for one passenger, where the wolf eats the duck and the duck
+ * eats the corn, and behaves exactly like FWDCstate.
+ *
+ * Puzzle files hold one declaration per line, '#' starts a comment:
+ * @code
+ * items F W D C      # the farmer comes first
+ * capacity 1         # passengers besides the farmer
+ * conflict W D       # never left together without the farmer
+ * conflict D C
+ * start [||FWDC]     # optional, defaults to everything on the right bank
+ * goal [FWDC||]      # optional, defaults to everything on the left bank
+ * invariant F        # optional, an odd number of these crosses every time
+ * @endcode
+ * Items with names longer than one character are separated by commas in the
+ * bracket notation, e.g. "[Farmer,Duck||Wolf,Corn]".
+ *
+ * An invariant is a set of items an odd number of which is in every boat load,
+ * so the parity of how many are on the left bank flips with every crossing and
+ * tells the parity of the length of any path. The farmer alone is always one, a
+ * declared one is checked against the boat loads when the puzzle is loaded.
+ */
+class Puzzle{
+public:
+	static const unsigned int MAX_ITEMS = 31;///<states are packed into a State
+	static const unsigned int MAX_LOADS = 1 << 16;///<limit on the number of distinct boat loads
+	static const unsigned int MAX_NAME = 255;///<longest item name
+	static const int PARITY_ANY = -1;///<pathParity() of a goal no invariant is fixed by
+	static const int PARITY_NEVER = -2;///<pathParity() of a goal the invariants rule out
+
+	std::vector <std::string> items;///<item names, the farmer first
+	unsigned int capacity;///<items the boat carries besides the farmer
+	std::vector <State> conflicts;///<pairs of items that can't be left alone together, as masks of two bits
+	std::vector <State> loads;///<every boat load, farmer included, fewest passengers first
+	std::vector <State> invariants;///<sets of items whose count on the left bank flips every crossing, the farmer alone first
+	State start;///<default start state
+	State goal;///<default goal state, all items matter
+	ItemNames names;///<name table for formatState() and parseState(), points into items
+
+	///@brief Construct the farmer, wolf, duck and corn puzzle
+	Puzzle(){
+		static const char * const classic[4] = {"F", "W", "D", "C"};
+		items.assign(classic, classic + 4);
+		capacity = 1;
+		conflicts.push_back(2 | 4);
+		conflicts.push_back(4 | 8);
+		invariants.assign(1, 1);
+		start = 0;
+		goal = 15;
+		buildTables();
+	}
+
+	Puzzle(const Puzzle &other){
+		*this = other;
+	}
+
+	Puzzle &operator=(const Puzzle &other){
+		items = other.items;
+		capacity = other.capacity;
+		conflicts = other.conflicts;
+		invariants = other.invariants;
+		start = other.start;
+		goal = other.goal;
+		buildTables();
+		return *this;
+	}
+
+	///@brief Mask of every item in the puzzle
+	State all()const{
+		return (1u << items.size()) - 1;
+	}
+
+	///@brief Is a state legal, with no conflicting pair left alone on either bank?
+	bool legal(State s)const{
+		State alone = (s & 1) ? ~s & all() : s;
+		for(unsigned int i = 0; i < conflicts.size(); ++i){
+			if((alone & conflicts[i]) == conflicts[i])
+				return false;
+		}
+		return true;
+	}
+
+	///@brief Get all legal moves that can be made from a state
+	///@param s The state to move from
+	///@param out Cleared and filled with the moves, in the order of loads
+	void nextMoves(State s, std::vector <Move> &out)const{
+		out.clear();
+		bool farmerLeft = s & 1;
+		State side = farmerLeft ? s : ~s & all();
+		for(unsigned int i = 0; i < loads.size(); ++i){
+			if((loads[i] & side) == loads[i] and legal(s ^ loads[i]))
+				out.push_back(Move(loads[i], !farmerLeft));
+		}
+	}
+
+	///@brief Parity of the number of crossings of every path from a state to a goal
+	///@return 0 or 1 from the invariants whose items all matter to the goal, PARITY_ANY if
+	///	there are none, PARITY_NEVER if they disagree and no path exists
+	int pathParity(State s, const Goal &target)const{
+		int rval = PARITY_ANY;
+		for(unsigned int i = 0; i < invariants.size(); ++i){
+			if((invariants[i] & target.mask) != invariants[i])
+				continue;
+			int parity = countItems((s ^ target.state) & invariants[i]) & 1;
+			if(rval != PARITY_ANY and parity != rval)
+				return PARITY_NEVER;
+			rval = parity;
+		}
+		return rval;
+	}
+
+	///@brief Heuristic number of moves left: items on the wrong bank over the boat capacity
+	///@note Consistent, since one crossing changes the bank of at most capacity items
+	int h(State s, const Goal &target)const{
+		int wrong = countItems((s ^ target.state) & target.mask & ~1u);
+		return (wrong + (int)capacity - 1) / (int)capacity;
+	}
+
+	///@brief Heuristic number of moves left, counting the crossings needed in each direction
+	///
+	///The crossings to the left carry at most capacity of the wrong items on the
+	///right bank, the crossings to the right likewise, and the two alternate starting
+	///from the farmer's bank. The fewest crossings meeting both counts, and leaving the
+	///farmer on his goal bank, is never less than h().
+	///@note Consistent, it is the exact distance when only those counts matter
+	int crossings(State s, const Goal &target)const{
+		State wrong = (s ^ target.state) & target.mask & ~1u;
+		int cap = (int)capacity;
+		int toLeft = (countItems(wrong & ~s) + cap - 1) / cap;
+		int toRight = (countItems(wrong & s) + cap - 1) / cap;
+		//n crossings make (n + 1) / 2 away from the farmer's bank and n / 2 back
+		int away = (s & 1) ? toRight : toLeft, back = (s & 1) ? toLeft : toRight;
+		int rval = std::max(std::max(2 * away - 1, 2 * back), 0);
+		if((target.mask & 1) and ((s ^ target.state) & 1) != (State)(rval & 1))
+			++rval;
+		return rval;
+	}
+
+	///@brief Get the legal moves from a state that raise f = g + h by exactly delta, for partial expansion
+	///
+	///A crossing costs one and changes h only through how many wrong and right items
+	///it carries, so the loads are built from those counts: each mix of wrong, right
+	///and unconstrained passengers gives one increase, and only the mixes with the
+	///increase asked for are turned into moves and checked for legality.
+	///@param s The state to move from
+	///@param target The goal h() is measured to
+	///@param delta The increase of f wanted, from 0 to 2
+	///@param out Cleared and filled with the moves
+	///@return The smallest increase above delta that some load gives, -1 if none does
+	int partialMoves(State s, const Goal &target, int delta, std::vector <Move> &out)const;
+
+	///@brief Length of the longest bracket notation of a state or move of this puzzle
+	unsigned int textLength()const{
+		return longest;
+	}
+
+	///@brief Write a state in the bracket notation, see formatState()
+	std::to_chars_result format(char * first, char * last, State s)const{
+		return formatState(first, last, s, names);
+	}
+
+	///@brief Read a state in the bracket notation, see parseState()
+	std::from_chars_result parse(const char * first, const char * last, State &s)const{
+		unsigned long bits = 0;
+		std::from_chars_result rval = parseState(first, last, bits, names);
+		if(rval.ec == std::errc())
+			s = (State)bits;
+		return rval;
+	}
+
+	///@brief Read a whole token as a state
+	///@return False unless the token is exactly one state in the bracket notation
+	bool parse(const std::string &token, State &s)const{
+		std::from_chars_result r = parse(token.data(), token.data() + token.size(), s);
+		return r.ec == std::errc() and r.ptr == token.data() + token.size();
+	}
+
+	///@brief Write a state to a stream in the bracket notation
+	void write(std::ostream &out, State s)const{
+		char buffer[256];
+		if(textLength() <= sizeof(buffer)){
+			out.write(buffer, format(buffer, buffer + sizeof(buffer), s).ptr - buffer);
+		}else{
+			std::string text(textLength(), ' ');
+			out.write(&text[0], format(&text[0], &text[0] + text.size(), s).ptr - &text[0]);
+		}
+	}
+
+	///@brief Write a move to a stream, see formatMove()
+	void write(std::ostream &out, const Move &move)const{
+		char buffer[256];
+		if(textLength() <= sizeof(buffer)){
+			out.write(buffer, formatMove(buffer, buffer + sizeof(buffer), move, names).ptr - buffer);
+		}else{
+			std::string text(textLength(), ' ');
+			out.write(&text[0], formatMove(&text[0], &text[0] + text.size(), move, names).ptr - &text[0]);
+		}
+	}
+
+	///@brief Get a string representation of a state
+	std::string toString(State s)const{
+		std::ostringstream out;
+		write(out, s);
+		return out.str();
+	}
+
+	///@brief Get a string representation of a move
+	std::string toString(const Move &move)const{
+		std::ostringstream out;
+		write(out, move);
+		return out.str();
+	}
+
+	///@brief Replace this puzzle with one read from a puzzle definition
+	///@param first Start of the definition text
+	///@param last One past the end of the definition text
+	///@param error Set to a description of the problem on failure
+	///@return False if the definition is malformed, the puzzle is unchanged then
+	bool load(const char * first, const char * last, std::string &error);
+
+	///@brief Replace this puzzle with one read from a puzzle file
+	///@return False if the file can't be read or is malformed, error says why
+	bool loadFile(const std::string &path, std::string &error);
+
+	///@brief Index of the item with a name, -1 if there is none
+	int find(const std::string &name)const{
+		for(unsigned int i = 0; i < items.size(); ++i){
+			if(items[i] == name)
+				return (int)i;
+		}
+		return -1;
+	}
+
+private:
+	std::vector <const char *> namePointers;
+	std::vector <unsigned char> nameLengths;
+	unsigned int longest;///<see textLength()
+
+	///@brief Add the boat loads with exactly count passengers chosen from items from and up
+	bool addLoads(State load, unsigned int from, unsigned int count);
+
+	///@brief Rebuild the name table and boat loads after the items change
+	///@return False if there are too many boat loads
+	bool buildTables();
+};
+
+/**
+ * @brief Compact encoding of a solution path as a packed stream of move indices
+ *
+ * The direction of every crossing is implied by the side the farmer is on, so a
+ * step only needs to name which items were in the boat. Each step is stored as
+ * an index into the alphabet of possible boat loads using ceil(log2(alphabet size))
+ * bits, and the path is recovered by replaying the moves from the start state.
+ */
+class PathCode{
+public:
+	std::vector <State> alphabet;///<the possible boat loads, a step stores an index into this
+	unsigned int bitsPerStep;///<number of bits used to store each step
+	unsigned int steps;///<number of moves in the encoded path
+	std::vector <unsigned char> data;///<the packed steps, least significant bits first
+
+	///@brief Construct an empty path over the boat loads of a puzzle
+	explicit PathCode(const Puzzle &puzzle){
+		init(puzzle.loads);
+	}
+
+	///@brief Construct an empty path over an arbitrary alphabet of boat loads
+	///@param loads packed bitmasks of every boat load a step may use
+	explicit PathCode(const std::vector <State> &loads){
+		init(loads);
+	}
+
+	///@brief Append a move to the end of the path
+	///@return False if the boat load is not in the alphabet
+	bool push(const Move &move){
+		for(unsigned int i = 0; i < alphabet.size(); ++i){
+			if(alphabet[i] == move.carried){
+				pushIndex(i);
+				return true;
+			}
+		}
+		return false;
+	}
+
+	///@brief Get the alphabet index stored for a step
+	unsigned int index(unsigned int step)const{
+		unsigned int rval = 0;
+		unsigned long bit = (unsigned long)step * bitsPerStep;
+		for(unsigned int i = 0; i < bitsPerStep; ++i, ++bit){
+			if(data[bit >> 3] & (1 << (bit & 7)))
+				rval |= 1u << i;
+		}
+		return rval;
+	}
+
+	///@brief Replay the encoded path from a start state
+	///@param puzzle The puzzle the path belongs to
+	///@param start The state the path was encoded from
+	///@param moves Filled with the decoded moves
+	///@return False if the code is corrupt or a step is illegal in the state it is replayed in
+	bool decode(const Puzzle &puzzle, State start, std::vector <Move> &moves)const{
+		moves.clear();
+		if(data.size() < ((unsigned long)steps * bitsPerStep + 7) / 8)
+			return false;
+		std::vector <Move> legal;
+		for(unsigned int step = 0; step < steps; ++step){
+			unsigned int i = index(step);
+			if(i >= alphabet.size())
+				return false;
+			Move move(alphabet[i], !(start & 1));
+			puzzle.nextMoves(start, legal);
+			if(std::find(legal.begin(), legal.end(), move) == legal.end())
+				return false;
+			moves.push_back(move);
+			start ^= move.carried;
+		}
+		return true;
+	}
+
+	///@brief Get the packed steps as a hexadecimal string, first byte first
+	std::string toHex()const{
+		static const char digits[] = "0123456789abcdef";
+		std::string rval;
+		for(unsigned int i = 0; i < data.size(); ++i){
+			rval += digits[data[i] >> 4];
+			rval += digits[data[i] & 15];
+		}
+		return rval;
+	}
+
+	///@brief Read back packed steps written by toHex(), replacing the path
+	///@param count Number of moves in the path
+	///@param hex The packed steps, exactly as many digits as count steps take
+	///@return False, leaving the path empty, if a digit is not hexadecimal, the length
+	///	is wrong or a bit after the last step is set
+	bool fromHex(unsigned int count, const std::string &hex){
+		steps = 0;
+		data.clear();
+		unsigned long bits = (unsigned long)count * bitsPerStep;
+		if(hex.size() != (bits + 7) / 8 * 2)
+			return false;
+		for(std::size_t i = 0; i < hex.size(); i += 2){
+			int high = hexDigit(hex[i]), low = hexDigit(hex[i + 1]);
+			if(high < 0 or low < 0){
+				data.clear();
+				return false;
+			}
+			data.push_back((unsigned char)(high << 4 | low));
+		}
+		if(bits % 8 != 0 and (data.back() >> (bits % 8)) != 0){
+			data.clear();
+			return false;
+		}
+		steps = count;
+		return true;
+	}
+
+private:
+	///@brief Value of a hexadecimal digit, -1 if it isn't one
+	static int hexDigit(char c){
+		return c >= '0' and c <= '9' ? c - '0' : c >= 'a' and c <= 'f' ? c - 'a' + 10 : c >= 'A' and c <= 'F' ? c - 'A' + 10 : -1;
+	}
+
+	void init(const std::vector <State> &loads){
+		alphabet = loads;
+		steps = 0;
+		bitsPerStep = 0;
+		while((1u << bitsPerStep) < alphabet.size())
+			++bitsPerStep;
+	}
+
+	void pushIndex(unsigned int i){
+		unsigned long bit = (unsigned long)steps * bitsPerStep;
+		for(unsigned int j = 0; j < bitsPerStep; ++j, ++bit){
+			if((bit >> 3) >= data.size())
+				data.push_back(0);
+			if(i & (1u << j))
+				data[bit >> 3] |= (unsigned char)(1 << (bit & 7));
+		}
+		++steps;
+	}
+};
+
+///@brief Read a query line: a start state and optionally a goal state, "-" for the puzzle's default
+///@return False if the line is not a query
+bool parseQuery(const Puzzle &puzzle, const char * first, const char * last, State &start, Goal &goal);
+
+#endif
@@ -0,0 +1,14 @@
+#!/bin/sh
+# Profile guided build: instrument, train on the benchmark suite, rebuild with the profiles.
+# usage: scripts/pgo-build.sh [build directory]
+set -e
+source_dir=$(cd "$(dirname "$0")/.." && pwd)
+build_dir=${1:-"$source_dir/build-pgo"}
+
+rm -rf "$build_dir/pgo-profile"
+cmake -S "$source_dir" -B "$build_dir" -DCMAKE_BUILD_TYPE=Release -DFWDC_PGO=GENERATE
+cmake --build "$build_dir" --parallel
+cmake --build "$build_dir" --target pgo-train
+cmake -S "$source_dir" -B "$build_dir" -DFWDC_PGO=USE
+cmake --build "$build_dir" --clean-first --parallel
+echo "Profile guided build in $build_dir"
@@ -0,0 +1,983 @@
+/**
+ * @file solver.cpp
+ * @brief The search algorithms run by SolverContext.
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <thread>
+
+#include "solver.h"
+
+using std::vector;
+using std::endl;
+
+typedef std::pair<Move, PSNode *> ChildPair;
+
+///@brief Follow parent links from a node to record the path reaching it
+static void backtrack(const PSNode * node, SearchResult &result){
+	result.found = true;
+	result.cost = node->cost2reach;
+	result.moves.clear();
+	for(; node->parent != NULL; node = node->parent)
+		result.moves.push_back(node->move);
+	std::reverse(result.moves.begin(), result.moves.end());
+}
+
+void SolverContext::solve(const Puzzle &puzzle, State start, const Goal &goal, SearchResult &result){
+	result.found = false;
+	result.cost = -1;
+	result.moves.clear();
+	result.expanded = 0;
+	result.generated = 0;
+	result.lookups = LookupStats();
+	result.evaluations = 0;
+	result.evaluationsSaved = 0;
+	if(!puzzle.legal(start) or puzzle.pathParity(start, goal) == Puzzle::PARITY_NEVER)
+		return;
+	nodes.setHugePages(options.hugePages);
+	for(int i = 0; i < 2; ++i){
+		tables[i].setHugePages(options.hugePages);
+		tables[i].setFilter(options.filter);
+	}
+	switch(options.algorithm){
+	case ALGORITHM_ASTAR:
+	case ALGORITHM_WEIGHTED:
+	case ALGORITHM_EPEA:
+	case ALGORITHM_LAZY:
+		searchAStar(puzzle, start, goal, result);
+		break;
+	case ALGORITHM_IDA:
+		searchIDA(puzzle, start, goal, result);
+		break;
+	case ALGORITHM_BFS:
+		searchBFS(puzzle, start, goal, result);
+		break;
+	case ALGORITHM_BIDIRECTIONAL:
+		searchBidirectional(puzzle, start, goal, result);
+		break;
+	case ALGORITHM_PARALLEL:
+		searchParallel(puzzle, start, goal, result);
+		break;
+	case ALGORITHM_BITMAP:
+		searchBitmap(puzzle, start, goal, result);
+		break;
+	case ALGORITHM_BDD:
+		searchBdd(puzzle, start, goal, result);
+		break;
+	case ALGORITHM_PATHS:
+		searchPaths(puzzle, start, goal, result);
+		break;
+	case ALGORITHM_HIERARCHY:
+		searchHierarchy(puzzle, start, goal, result);
+		break;
+	case ALGORITHM_REALTIME:
+		searchRealTime(puzzle, start, goal, result);
+		break;
+	}
+	recycle();
+}
+
+///@brief Hand everything a search used back for the next one
+void SolverContext::recycle(){
+	nodes.reset();
+	tables[0].clear();
+	tables[1].clear();
+	multimapFrontier.clear();
+	heapFrontier.clear();
+	bucketFrontier.clear();
+}
+
+///@brief Build or map the tables behind the heuristics a search uses, and aim them at its goal
+void SolverContext::prepareHeuristics(const Puzzle &puzzle, const Goal &goal, const vector <Heuristic> &heuristics){
+	if(std::find(heuristics.begin(), heuristics.end(), HEURISTIC_PATTERN) != heuristics.end())
+		patterns.prepare(puzzle, goal);
+	if(std::find(heuristics.begin(), heuristics.end(), HEURISTIC_LANDMARKS) != heuristics.end()){
+		if(!landmarks.prepare(puzzle, options.landmarkFile) and options.trace >= 1)
+			*options.log << "Landmark tables not saved to " << options.landmarkFile << endl;
+		landmarks.target(goal);
+	}
+	if(std::find(heuristics.begin(), heuristics.end(), HEURISTIC_LEARNED) != heuristics.end())
+		learned.prepare(puzzle, goal);
+}
+
+///@brief Largest of a state's heuristics from first up to end, raised to the parity of its paths to the goal
+int SolverContext::estimate(const Puzzle &puzzle, State s, const Goal &goal, const vector <Heuristic> &heuristics,
+		unsigned int first, unsigned int end, SearchResult &result){
+	int rval = 0;
+	for(unsigned int i = first; i < end; ++i){
+		int h = 0;
+		switch(heuristics[i]){
+		case HEURISTIC_COUNTING:
+			h = puzzle.h(s, goal);
+			break;
+		case HEURISTIC_CROSSINGS:
+			h = puzzle.crossings(s, goal);
+			break;
+		case HEURISTIC_PATTERN:
+			h = patterns.h(s);
+			break;
+		case HEURISTIC_LANDMARKS:
+			h = landmarks.h(s);
+			break;
+		case HEURISTIC_LEARNED:
+			h = learned.h(s);
+			break;
+		}
+		rval = std::max(rval, h);
+	}
+	result.evaluations += end - first;
+	//every path to the goal has the parity the invariants give, so a bound of the other parity is one short;
+	//partial expansion works its children's f out from the counting heuristic alone, so it goes without
+	int parity = puzzle.pathParity(s, goal);
+	if(parity >= 0 and (rval & 1) != parity and options.algorithm != ALGORITHM_EPEA)
+		++rval;
+	return rval;
+}
+
+///@brief A*, weighted A*, enhanced partial expansion A* and lazy A* with a choice of frontier
+///
+///Partial expansion keeps a node's priority at its f plus the increase of f its
+///next children will have. Expanding it generates only those children and puts it
+///back with the next larger increase, so children that wouldn't be expanded before
+///the goal is found never reach the table or the frontier.
+///
+///Lazy A* gives new nodes only the first heuristic, and evaluates the rest when a
+///node reaches the top of the frontier, putting it back if its f went up. Nodes
+///still waiting when the goal is found never pay for the expensive heuristics.
+///
+///With the learned heuristic, once A* or lazy A* finds the goal at cost C every
+///node it expanded learns C less its cost to reach, as in Adaptive A*, so the next
+///search for the same goal starts better informed. Weighted A* only uses the costs,
+///its C may be above the optimal and would teach too much.
+void SolverContext::searchAStar(const Puzzle &puzzle, State start, const Goal &goal, SearchResult &result){
+	std::ostream &log = *options.log;
+	int weight = options.algorithm == ALGORITHM_WEIGHTED ? (int)std::lround(options.weight * WEIGHT_SCALE) : WEIGHT_SCALE;
+	PSNode * winningNode = NULL;
+
+	//partial expansion works out the f of children from the counting heuristic, so it uses that alone,
+	//the front ends turn any other list down and this keeps options set some other way safe
+	static const vector <Heuristic> counting(1, HEURISTIC_COUNTING);
+	const vector <Heuristic> &heuristics = options.algorithm == ALGORITHM_EPEA or options.heuristics.empty()
+			? counting : options.heuristics;
+	unsigned int eager = options.algorithm == ALGORITHM_LAZY ? 1 : (unsigned int)heuristics.size();
+	prepareHeuristics(puzzle, goal, heuristics);
+	bool learning = (options.algorithm == ALGORITHM_ASTAR or options.algorithm == ALGORITHM_LAZY)
+			and std::find(heuristics.begin(), heuristics.end(), HEURISTIC_LEARNED) != heuristics.end();
+	expandedNodes.clear();
+
+	//table of all generated gamestates to their problem space graph nodes
+	StateTable &generated = tables[0];
+
+	//all frontier nodes by their f() costs
+	Frontier &frontier = options.frontier == FRONTIER_HEAP ? (Frontier &)heapFrontier
+			: options.frontier == FRONTIER_BUCKET ? (Frontier &)bucketFrontier : (Frontier &)multimapFrontier;
+
+	//node currently being evaluated, begins at problem start state;
+	PSNode *tempNode = nodes.allocate(start, NULL, Move(), estimate(puzzle, start, goal, heuristics, 0, eager, result));
+	tempNode->estimated = (unsigned char)eager;
+	PSNode * workNode = NULL;//just a temp
+	vector <PSNode *> &listed = next;
+
+	//Add start state to generated nodes and frontier
+	tempNode->priority = weight * tempNode->projectedCost;
+	generated.insert(tempNode);
+	frontier.push(tempNode);
+	result.generated = 1;
+
+	//While we haven't won or lost
+	while(winningNode == NULL and ! frontier.empty()){
+
+		//output the current frontier nodes
+		if(options.trace >= 2){
+			log << "Frontier nodes are:\t";
+			frontier.list(listed);
+			for(unsigned int i = 0; i < listed.size(); ++i){
+				puzzle.write(log, listed[i]->state);
+				log << " h="<< listed[i]->projectedCost
+						<< " g="<< listed[i]->cost2reach
+						<< " f="<< listed[i]->cost2reach + listed[i]->projectedCost << endl;
+			}
+		}
+
+		//chose the node with the lowest cost in the frontier
+		tempNode = frontier.pop();
+		if(options.trace >= 1){
+			log << "Expand:\t";
+			puzzle.write(log, tempNode->state);
+			log << endl;
+		}
+		if(goal.matches(tempNode->state)){
+			winningNode = tempNode;
+			break;
+		}
+
+		//the heuristics lazy A* put off, the node goes back if they raise its f
+		if(tempNode->estimated < heuristics.size()){
+			int h = estimate(puzzle, tempNode->state, goal, heuristics, tempNode->estimated, (unsigned int)heuristics.size(), result);
+			tempNode->estimated = (unsigned char)heuristics.size();
+			if(h > tempNode->projectedCost){
+				if(options.trace >= 1)
+					log << "Raised:\th=" << tempNode->projectedCost << " to h=" << h << endl;
+				tempNode->priority += (h - tempNode->projectedCost) * weight;
+				tempNode->projectedCost = h;
+				frontier.push(tempNode);
+				continue;
+			}
+		}
+
+		//expand it
+		++result.expanded;
+		if(learning)
+			expandedNodes.push_back(tempNode);
+		if(options.algorithm == ALGORITHM_EPEA){
+			int delta = tempNode->priority / WEIGHT_SCALE - tempNode->cost2reach - tempNode->projectedCost;
+			int later = puzzle.partialMoves(tempNode->state, goal, delta, moves);
+			if(later >= 0){//put it back for the children it has left
+				tempNode->priority += (later - delta) * WEIGHT_SCALE;
+				frontier.push(tempNode);
+			}
+		}else{
+			puzzle.nextMoves(tempNode->state, moves);
+		}
+		//start every child's table lookup before making the first, so their cache misses overlap
+		for(unsigned int i = 0; i < moves.size(); ++i)
+			generated.prefetch(tempNode->state ^ moves[i].carried);
+		for(unsigned int i = 0; i < moves.size();++i){
+			//carrying the same items straight back only leads to the parent state
+			if(tempNode->parent != NULL and moves[i] == tempNode->move.inverse())
+				continue;
+			State child = tempNode->state ^ moves[i].carried;
+			if(options.trace >= 2){
+				log << "Generated:\t";
+				puzzle.write(log, moves[i]);
+				log << '\t';
+				puzzle.write(log, child);
+				log << '\t';
+			}
+
+			//if state in question is already generated, updated if neccesary
+			workNode = generated.find(child, result.lookups);
+			if(workNode != NULL){
+				bool updated = workNode->updateCostCond(tempNode->cost2reach + moves[i].cost(), tempNode, moves[i], frontier);
+				if(options.trace >= 2)
+					log << "Regenerated\t" << (updated ? "Updated F\t" : "No update\t");
+			}else{//generate the graph node for this state
+				if(options.trace >= 2)
+					log << "New node\t        \t";
+				workNode = nodes.allocate(child, tempNode, moves[i], estimate(puzzle, child, goal, heuristics, 0, eager, result));
+				workNode->estimated = (unsigned char)eager;
+				workNode->priority = workNode->cost2reach * WEIGHT_SCALE + weight * workNode->projectedCost;
+				generated.insert(workNode);
+				frontier.push(workNode);
+				++result.generated;
+			}
+
+			//Add the node, generated or new to the children of tempNode
+			tempNode->children.push_back(ChildPair(moves[i], workNode));
+
+			if(options.trace >= 2){
+				log << "g=" << workNode->cost2reach
+						<< " h=" << workNode->projectedCost
+						<< " f=" << workNode->cost2reach + workNode->projectedCost
+						<< endl;
+			}
+		}
+	}
+
+	result.evaluationsSaved = result.generated * heuristics.size() - result.evaluations;
+	if(winningNode != NULL){
+		backtrack(winningNode, result);
+		//a better path found later may have lowered a node's cost to reach, the bound holds for any path to it
+		for(unsigned int i = 0; learning and i < expandedNodes.size(); ++i)
+			learned.learn(expandedNodes[i]->state, result.cost - expandedNodes[i]->cost2reach);
+		if(learning and options.trace >= 1)
+			log << "Learned:\t" << expandedNodes.size() << " states" << endl;
+	}
+}
+
+static const int IDA_FOUND = -1;
+static const int IDA_NOT_FOUND = 0x7fffffff;
+
+///@brief Iterative deepening A*, a depth first search bounded by f() that raises the bound each pass
+///@note The current path is kept in path and result.moves, so no table of nodes is needed.
+void SolverContext::searchIDA(const Puzzle &puzzle, State start, const Goal &goal, SearchResult &result){
+	path.assign(1, start);
+	int bound = puzzle.h(start, goal);
+	result.generated = 1;
+	for(;;){
+		if(options.trace >= 1)
+			*options.log << "Bound:\t" << bound << endl;
+		int next = visitIDA(puzzle, goal, 0, bound, result);
+		if(next == IDA_FOUND){
+			result.found = true;
+			result.cost = 0;
+			for(unsigned int i = 0; i < result.moves.size(); ++i)
+				result.cost += result.moves[i].cost();
+			return;
+		}
+		if(next == IDA_NOT_FOUND)
+			return;
+		bound = next;
+	}
+}
+
+///@brief Search below the last state of the path
+///@return IDA_FOUND, or the smallest f() that exceeded the bound, IDA_NOT_FOUND if none did
+int SolverContext::visitIDA(const Puzzle &puzzle, const Goal &goal, int g, int bound, SearchResult &result){
+	State state = path.back();
+	int f = g + puzzle.h(state, goal);
+	if(f > bound)
+		return f;
+	if(options.trace >= 1){
+		*options.log << "Expand:\t";
+		puzzle.write(*options.log, state);
+		*options.log << endl;
+	}
+	if(goal.matches(state))
+		return IDA_FOUND;
+
+	++result.expanded;
+	int next = IDA_NOT_FOUND;
+	vector <Move> successors;
+	puzzle.nextMoves(state, successors);
+	for(unsigned int i = 0; i < successors.size(); ++i){
+		State child = state ^ successors[i].carried;
+		//never revisit a state already on the path
+		if(std::find(path.begin(), path.end(), child) != path.end())
+			continue;
+		++result.generated;
+		path.push_back(child);
+		result.moves.push_back(successors[i]);
+		int t = visitIDA(puzzle, goal, g + successors[i].cost(), bound, result);
+		if(t == IDA_FOUND)
+			return IDA_FOUND;
+		next = std::min(next, t);
+		path.pop_back();
+		result.moves.pop_back();
+	}
+	return next;
+}
+
+///@brief Breadth first search, testing for the goal as states are generated
+void SolverContext::searchBFS(const Puzzle &puzzle, State start, const Goal &goal, SearchResult &result){
+	std::ostream &log = *options.log;
+	StateTable &generated = tables[0];
+	vector <PSNode *> &queue = layers[0];
+	PSNode * winningNode = NULL;
+
+	PSNode * node = nodes.allocate(start, NULL, Move(), 0);
+	generated.insert(node);
+	queue.assign(1, node);
+	result.generated = 1;
+	if(goal.matches(start))
+		winningNode = node;
+	//only layers of the parity the invariants give can hold goal states
+	int parity = puzzle.pathParity(start, goal);
+	bool goalLayer[2] = {parity != 1, parity != 0};
+
+	for(std::size_t head = 0; winningNode == NULL and head < queue.size(); ++head){
+		node = queue[head];
+		if(options.trace >= 1){
+			log << "Expand:\t";
+			puzzle.write(log, node->state);
+			log << endl;
+		}
+		++result.expanded;
+		puzzle.nextMoves(node->state, moves);
+		for(unsigned int i = 0; i < moves.size(); ++i)
+			generated.prefetch(node->state ^ moves[i].carried);
+		for(unsigned int i = 0; winningNode == NULL and i < moves.size(); ++i){
+			State child = node->state ^ moves[i].carried;
+			if(generated.find(child, result.lookups) != NULL)
+				continue;
+			if(options.trace >= 2){
+				log << "Generated:\t";
+				puzzle.write(log, moves[i]);
+				log << '\t';
+				puzzle.write(log, child);
+				log << endl;
+			}
+			PSNode * workNode = nodes.allocate(child, node, moves[i], 0);
+			generated.insert(workNode);
+			queue.push_back(workNode);
+			++result.generated;
+			if(goalLayer[workNode->cost2reach & 1] and goal.matches(child))
+				winningNode = workNode;
+		}
+	}
+
+	if(winningNode != NULL)
+		backtrack(winningNode, result);
+}
+
+///@brief Breadth first search from the start and from every goal state at once, a layer at a time
+///@note Moves are reversible, so the backward search uses the same successors as the forward one.
+void SolverContext::searchBidirectional(const Puzzle &puzzle, State start, const Goal &goal, SearchResult &result){
+	std::ostream &log = *options.log;
+	PSNode * meet[2] = {NULL, NULL};
+
+	PSNode * node = nodes.allocate(start, NULL, Move(), 0);
+	tables[0].insert(node);
+	layers[0].assign(1, node);
+	layers[1].clear();
+	//seed the backward search with every legal state the goal accepts
+	State free = ~goal.mask & puzzle.all();
+	State bits = 0;
+	do{
+		State s = (goal.state & goal.mask) | bits;
+		if(puzzle.legal(s)){
+			node = nodes.allocate(s, NULL, Move(), 0);
+			tables[1].insert(node);
+			layers[1].push_back(node);
+		}
+		bits = (bits - free) & free;
+	}while(bits != 0);
+	result.generated = tables[0].size() + tables[1].size();
+	if(tables[1].find(start) != NULL){
+		meet[0] = tables[0].find(start);
+		meet[1] = tables[1].find(start);
+	}
+
+	while(meet[0] == NULL and !layers[0].empty() and !layers[1].empty()){
+		//grow whichever side has the smaller layer
+		int side = layers[0].size() <= layers[1].size() ? 0 : 1;
+		next.clear();
+		for(unsigned int n = 0; meet[0] == NULL and n < layers[side].size(); ++n){
+			node = layers[side][n];
+			if(options.trace >= 1){
+				log << (side ? "Expand backward:\t" : "Expand forward:\t");
+				puzzle.write(log, node->state);
+				log << endl;
+			}
+			++result.expanded;
+			puzzle.nextMoves(node->state, moves);
+			for(unsigned int i = 0; i < moves.size(); ++i){
+				tables[side].prefetch(node->state ^ moves[i].carried);
+				tables[1 - side].prefetch(node->state ^ moves[i].carried);
+			}
+			for(unsigned int i = 0; i < moves.size(); ++i){
+				State child = node->state ^ moves[i].carried;
+				if(tables[side].find(child, result.lookups) != NULL)
+					continue;
+				if(options.trace >= 2){
+					log << "Generated:\t";
+					puzzle.write(log, moves[i]);
+					log << '\t';
+					puzzle.write(log, child);
+					log << endl;
+				}
+				PSNode * workNode = nodes.allocate(child, node, moves[i], 0);
+				tables[side].insert(workNode);
+				next.push_back(workNode);
+				++result.generated;
+				//the first meeting is optimal, no shorter path existed before this layer
+				PSNode * other = tables[1 - side].find(child, result.lookups);
+				if(other != NULL){
+					meet[side] = workNode;
+					meet[1 - side] = other;
+					break;
+				}
+			}
+		}
+		layers[side].swap(next);
+	}
+
+	if(meet[0] != NULL){
+		backtrack(meet[0], result);
+		//walk the backward half from the meeting point to the goal, reversing its moves
+		for(node = meet[1]; node->parent != NULL; node = node->parent){
+			result.moves.push_back(node->move.inverse());
+			result.cost += node->move.cost();
+		}
+	}
+}
+
+///@brief How many candidates ahead the parallel search's merge prefetches table slots
+static const std::size_t PREFETCH_DISTANCE = 8;
+
+///@brief Expand a slice of a breadth first layer, reading but never writing the table of seen states
+void SolverContext::expandSlice(const Puzzle &puzzle, const StateTable &seen, const vector <PSNode *> &layer,
+		std::size_t begin, std::size_t end, vector <Candidate> &out, LookupStats &stats){
+	vector <Move> moves;
+	for(std::size_t n = begin; n < end; ++n){
+		puzzle.nextMoves(layer[n]->state, moves);
+		for(unsigned int i = 0; i < moves.size(); ++i)
+			seen.prefetch(layer[n]->state ^ moves[i].carried);
+		for(unsigned int i = 0; i < moves.size(); ++i){
+			Candidate candidate = {layer[n]->state ^ moves[i].carried, layer[n], moves[i]};
+			if(seen.find(candidate.state, stats) == NULL)
+				out.push_back(candidate);
+		}
+	}
+}
+
+///@brief Breadth first search with every layer split between worker threads
+///@note Candidates are merged in thread order, so the result doesn't depend on the thread count.
+void SolverContext::searchParallel(const Puzzle &puzzle, State start, const Goal &goal, SearchResult &result){
+	std::ostream &log = *options.log;
+	StateTable &seen = tables[0];
+	vector <PSNode *> &layer = layers[0];
+	PSNode * winningNode = NULL;
+	unsigned int threads = std::max(options.threads, 1u);
+	candidates.resize(threads);
+	sliceLookups.assign(threads, LookupStats());
+
+	PSNode * node = nodes.allocate(start, NULL, Move(), 0);
+	seen.insert(node);
+	layer.assign(1, node);
+	result.generated = 1;
+	if(goal.matches(start))
+		winningNode = node;
+	int parity = puzzle.pathParity(start, goal);
+	bool goalLayer[2] = {parity != 1, parity != 0};
+
+	while(winningNode == NULL and !layer.empty()){
+		std::size_t slice = (layer.size() + threads - 1) / threads;
+		vector <std::thread> workers;
+		for(unsigned int t = 0; t < threads; ++t)
+			candidates[t].clear();
+		for(unsigned int t = 0; t < threads; ++t){
+			std::size_t begin = std::min(layer.size(), t * slice), end = std::min(layer.size(), begin + slice);
+			if(t + 1 == threads or end == layer.size())
+				expandSlice(puzzle, seen, layer, begin, end, candidates[t], sliceLookups[t]);
+			else
+				workers.push_back(std::thread(expandSlice, std::cref(puzzle), std::cref(seen), std::cref(layer), begin, end,
+						std::ref(candidates[t]), std::ref(sliceLookups[t])));
+			if(end == layer.size())
+				break;
+		}
+		for(unsigned int t = 0; t < workers.size(); ++t)
+			workers[t].join();
+		result.expanded += layer.size();
+		if(options.trace >= 1){
+			for(std::size_t n = 0; n < layer.size(); ++n){
+				log << "Expand:\t";
+				puzzle.write(log, layer[n]->state);
+				log << endl;
+			}
+		}
+
+		next.clear();
+		for(unsigned int t = 0; winningNode == NULL and t < threads; ++t){
+			for(std::size_t i = 0; i < candidates[t].size(); ++i){
+				//stay a few candidates ahead of the lookups
+				if(i + PREFETCH_DISTANCE < candidates[t].size())
+					seen.prefetch(candidates[t][i + PREFETCH_DISTANCE].state);
+				const Candidate &candidate = candidates[t][i];
+				if(seen.find(candidate.state, result.lookups) != NULL)
+					continue;
+				PSNode * workNode = nodes.allocate(candidate.state, candidate.parent, candidate.move, 0);
+				seen.insert(workNode);
+				next.push_back(workNode);
+				++result.generated;
+				if(goalLayer[workNode->cost2reach & 1] and goal.matches(candidate.state)){
+					winningNode = workNode;
+					break;
+				}
+			}
+		}
+		layer.swap(next);
+	}
+
+	for(unsigned int t = 0; t < threads; ++t)
+		result.lookups.add(sliceLookups[t]);
+	if(winningNode != NULL)
+		backtrack(winningNode, result);
+}
+
+///@brief Set a bitmap to the states matching a goal, a word at a time
+static void findGoals(unsigned int items, const Goal &goal, StateBitmap &goals){
+	goals.reset(items);
+	//with fewer than 6 items a single word holds every state and the rest of it
+	std::uint64_t valid = items < 6 ? ((std::uint64_t)1 << (1u << items)) - 1 : ~(std::uint64_t)0;
+	for(std::size_t w = 0; w < goals.words.size(); ++w){
+		std::uint64_t matches = valid;
+		for(unsigned int k = 0; k < items; ++k){
+			if(goal.mask & (1u << k))
+				matches &= bitEquals(w, k, (goal.state >> k) & 1);
+		}
+		goals.words[w] = matches;
+	}
+}
+
+///@brief Breadth first search that keeps each layer as a bitmap of states and moves all of it at once
+///
+///The layers are kept for the walk back without the farmer's bit, which the
+///depth gives, in half the memory.
+///@note Puzzles with more than BITMAP_MAX_ITEMS items are solved by searchBFS() instead.
+void SolverContext::searchBitmap(const Puzzle &puzzle, State start, const Goal &goal, SearchResult &result){
+	unsigned int items = (unsigned int)puzzle.items.size();
+	if(items > BITMAP_MAX_ITEMS){
+		searchBFS(puzzle, start, goal, result);
+		return;
+	}
+	visitedStates.reset(items);
+	std::size_t words = visitedStates.words.size();
+	findLegal(puzzle, legalStates);
+	findGoals(items, goal, goalStates);
+
+	StateBitmap &layer = bitmapLayer, &next = bitmapNext;
+	layer.reset(items);
+	layer.set(start);
+	visitedStates.set(start);
+	result.generated = 1;
+	unsigned int depth = 0;
+	State found = 0;
+	//the goal can only be reached by paths whose length has the parity the invariants give
+	int parity = puzzle.pathParity(start, goal);
+	while(!((parity == Puzzle::PARITY_ANY or parity == (int)(depth & 1)) and layer.firstCommon(goalStates, found))){
+		if(options.trace >= 1)
+			*options.log << "Layer:\t" << depth << '\t' << layer.count() << endl;
+		result.expanded += layer.count();
+		if(bitmapLayers.size() == depth)
+			bitmapLayers.resize(depth + 1);
+		dropFarmer(items, layer, ((start ^ depth) & 1) != 0, bitmapLayers[depth]);
+
+		crossRiver(puzzle, layer, next, bitmapScratch);
+
+		std::size_t added = 0;
+		for(std::size_t w = 0; w < words; ++w){
+			next.words[w] &= legalStates.words[w] & ~visitedStates.words[w];
+			visitedStates.words[w] |= next.words[w];
+			added += StateBitmap::popcount(next.words[w]);
+		}
+		if(added == 0)
+			return;
+		result.generated += added;
+		layer.words.swap(next.words);
+		++depth;
+	}
+
+	//walk back through the layers, each state has a predecessor in the layer before
+	result.found = true;
+	result.cost = 0;
+	result.moves.clear();
+	State s = found;
+	for(unsigned int d = depth; d > 0; --d){
+		for(unsigned int i = 0; i < puzzle.loads.size(); ++i){
+			State load = puzzle.loads[i];
+			State before = s ^ load;
+			if(((s & load) == load or (s & load) == 0) and bitmapLayers[d - 1].test(before >> 1)){
+				Move move(load, !(before & 1));
+				result.moves.push_back(move);
+				result.cost += move.cost();
+				s = before;
+				break;
+			}
+		}
+	}
+	std::reverse(result.moves.begin(), result.moves.end());
+}
+
+///@brief Can a goal be reached from a state at all? Floods its component with the bitmaps of searchBitmap()
+///@note The puzzle must have at most BITMAP_MAX_ITEMS items.
+bool SolverContext::reachable(const Puzzle &puzzle, State start, const Goal &goal){
+	unsigned int items = (unsigned int)puzzle.items.size();
+	if(puzzle.pathParity(start, goal) == Puzzle::PARITY_NEVER)
+		return false;
+	findLegal(puzzle, legalStates);
+	findGoals(items, goal, goalStates);
+	StateBitmap &layer = bitmapLayer, &next = bitmapNext;
+	layer.reset(items);
+	layer.set(start);
+	visitedStates.reset(items);
+	visitedStates.set(start);
+	State found = 0;
+	while(!layer.firstCommon(goalStates, found)){
+		crossRiver(puzzle, layer, next, bitmapScratch);
+		std::uint64_t added = 0;
+		for(std::size_t w = 0; w < next.words.size(); ++w){
+			next.words[w] &= legalStates.words[w] & ~visitedStates.words[w];
+			visitedStates.words[w] |= next.words[w];
+			added |= next.words[w];
+		}
+		if(added == 0)
+			return false;
+		layer.words.swap(next.words);
+	}
+	return true;
+}
+
+///@brief Nodes the BDD search lets the manager hold before collecting garbage between layers
+static const std::size_t BDD_COLLECT_MIN = 1 << 16;
+
+///@brief Conjunction of the current state variables of the items in mask, true or false as in s
+///@note Item i is variable 2i of the BDD search, and its bank after a move variable 2i + 1.
+static BddRef stateSet(BddManager &bdd, State s, State mask){
+	BddRef rval = BDD_TRUE;
+	for(unsigned int i = BddManager::MAX_VARIABLES / 2; i-- > 0;){
+		if(mask & (1u << i)){
+			BddRef v = bdd.variable(2 * i);
+			rval = bdd.conjoin(s & (1u << i) ? v : bdd.negate(v), rval);
+		}
+	}
+	return rval;
+}
+
+///@brief Breadth first search over sets of states held as BDDs
+///
+///Each layer is the image of the one before under a transition relation over the
+///interleaved current and next state variables, so the work depends on how
+///regular the sets are rather than on how many states they hold.
+void SolverContext::searchBdd(const Puzzle &puzzle, State start, const Goal &goal, SearchResult &result){
+	unsigned int items = (unsigned int)puzzle.items.size();
+	bdd.clear(2 * items);
+	std::uint64_t current = 0;
+	for(unsigned int i = 0; i < items; ++i)
+		current |= (std::uint64_t)1 << (2 * i);
+	BddRef currentVars = bdd.cube(current);
+	BddRef nextVars = bdd.cube(current << 1);
+
+	//the farmer always crosses, and the state he leaves behind has to be legal
+	BddRef farmer = bdd.variable(0), farmerAfter = bdd.variable(1);
+	BddRef relation = bdd.negate(bdd.equal(farmer, farmerAfter));
+	for(unsigned int i = 0; i < puzzle.conflicts.size(); ++i){
+		unsigned int a = StateBitmap::lowestBit(puzzle.conflicts[i]);
+		unsigned int b = StateBitmap::lowestBit(puzzle.conflicts[i] & ~(1u << a));
+		BddRef after = bdd.variable(2 * a + 1);
+		BddRef together = bdd.equal(after, bdd.variable(2 * b + 1));
+		BddRef unattended = bdd.negate(bdd.equal(after, farmerAfter));
+		relation = bdd.conjoin(relation, bdd.negate(bdd.conjoin(together, unattended)));
+	}
+	//an item may cross only from the farmer's bank, and at most capacity of them do,
+	//counted from the last item up so atMost[c] is at most c of the items so far
+	vector <BddRef> atMost(puzzle.capacity + 1, BDD_TRUE);
+	for(unsigned int i = items; i-- > 1;){
+		BddRef item = bdd.variable(2 * i);
+		BddRef moved = bdd.negate(bdd.equal(item, bdd.variable(2 * i + 1)));
+		for(unsigned int c = puzzle.capacity + 1; c-- > 0;)
+			atMost[c] = bdd.ite(moved, c > 0 ? atMost[c - 1] : BDD_FALSE, atMost[c]);
+		relation = bdd.conjoin(relation, bdd.disjoin(bdd.negate(moved), bdd.equal(item, farmer)));
+	}
+	relation = bdd.conjoin(relation, atMost[puzzle.capacity]);
+
+	BddRef goalSet = stateSet(bdd, goal.state, goal.mask & puzzle.all());
+	bddLayers.assign(1, stateSet(bdd, start, puzzle.all()));
+	BddRef reached = bddLayers[0];
+	result.generated = 1;
+	std::size_t collectAt = BDD_COLLECT_MIN;
+	while(bdd.conjoin(bddLayers.back(), goalSet) == BDD_FALSE){
+		BddRef layer = bddLayers.back();
+		unsigned long count = (unsigned long)bdd.satCount(layer, items);
+		if(options.trace >= 1)
+			*options.log << "Layer:\t" << bddLayers.size() - 1 << '\t' << count << '\t' << bdd.size() << " nodes" << endl;
+		result.expanded += count;
+		BddRef image = bdd.shift(bdd.andExists(layer, relation, currentVars), -1);
+		BddRef next = bdd.conjoin(image, bdd.negate(reached));
+		if(next == BDD_FALSE)
+			return;
+		reached = bdd.disjoin(reached, next);
+		bddLayers.push_back(next);
+		result.generated += (unsigned long)bdd.satCount(next, items);
+
+		if(bdd.size() > collectAt){
+			bddRoots.assign(bddLayers.begin(), bddLayers.end());
+			BddRef roots[] = {reached, relation, goalSet, currentVars, nextVars};
+			bddRoots.insert(bddRoots.end(), roots, roots + sizeof(roots) / sizeof(roots[0]));
+			bdd.collect(bddRoots);
+			collectAt = std::max(BDD_COLLECT_MIN, 2 * bdd.size());
+		}
+	}
+
+	//pick a goal state and walk back, finding each predecessor as the preimage of one state
+	std::uint64_t assignment = 0;
+	bdd.pick(bdd.conjoin(bddLayers.back(), goalSet), assignment);
+	State s = 0;
+	for(unsigned int i = 0; i < items; ++i)
+		s |= (State)(assignment >> (2 * i) & 1) << i;
+	result.found = true;
+	result.cost = 0;
+	result.moves.clear();
+	for(std::size_t d = bddLayers.size() - 1; d > 0; --d){
+		BddRef after = bdd.shift(stateSet(bdd, s, puzzle.all()), 1);
+		BddRef before = bdd.conjoin(bdd.andExists(relation, after, nextVars), bddLayers[d - 1]);
+		bdd.pick(before, assignment);
+		State from = 0;
+		for(unsigned int i = 0; i < items; ++i)
+			from |= (State)(assignment >> (2 * i) & 1) << i;
+		Move move(from ^ s, !(from & 1));
+		result.moves.push_back(move);
+		result.cost += move.cost();
+		s = from;
+	}
+	std::reverse(result.moves.begin(), result.moves.end());
+}
+
+///@brief Follow the first moves a compressed path database gives, one lookup per move
+///@note Goals leaving some items free, and puzzles too large for a PathDatabase, are solved by searchBitmap() instead.
+void SolverContext::searchPaths(const Puzzle &puzzle, State start, const Goal &goal, SearchResult &result){
+	if((goal.mask & puzzle.all()) != puzzle.all() or !paths.prepare(puzzle)){
+		searchBitmap(puzzle, start, goal, result);
+		return;
+	}
+	State target = goal.state & puzzle.all();
+	result.generated = 1;
+	Move move;
+	for(State s = start; s != target; s ^= move.carried){
+		if(!paths.next(s, target, move)){
+			result.moves.clear();
+			return;
+		}
+		if(options.trace >= 1){
+			*options.log << "Move:\t";
+			puzzle.write(*options.log, move);
+			*options.log << endl;
+		}
+		result.moves.push_back(move);
+		++result.expanded;
+		++result.generated;
+	}
+	result.found = true;
+	result.cost = 0;
+	for(unsigned int i = 0; i < result.moves.size(); ++i)
+		result.cost += result.moves[i].cost();
+}
+
+///@brief Search a contraction hierarchy of the puzzle, preprocessed the first time the puzzle is solved
+///@note Goals leaving some items free, and puzzles too large for a ContractionHierarchy, are solved by searchBitmap() instead.
+void SolverContext::searchHierarchy(const Puzzle &puzzle, State start, const Goal &goal, SearchResult &result){
+	if((goal.mask & puzzle.all()) != puzzle.all() or puzzle.items.size() > ContractionHierarchy::MAX_ITEMS){
+		searchBitmap(puzzle, start, goal, result);
+		return;
+	}
+	if(!hierarchy.prepare(puzzle, options.hierarchyFile, options.threads) and options.trace >= 1)
+		*options.log << "Contraction hierarchy not saved to " << options.hierarchyFile << endl;
+	if(!hierarchy.route(start, goal.state & puzzle.all(), result.moves, result.expanded))
+		return;
+	if(options.trace >= 1)
+		*options.log << "Settled:\t" << result.expanded << endl;
+	result.found = true;
+	result.cost = 0;
+	for(unsigned int i = 0; i < result.moves.size(); ++i)
+		result.cost += result.moves[i].cost();
+}
+
+///@brief Real-time adaptive A*, a move after each lookahead until the goal is reached
+///
+///An unreachable goal would only be given up on once the costs learned across the
+///start's whole component reached LearnedHeuristic::UNREACHABLE, so the component
+///is flooded first and such a goal is not found without a single move.
+///@note Puzzles too large to learn costs for could go round in circles for ever, they are solved by searchAStar() instead.
+void SolverContext::searchRealTime(const Puzzle &puzzle, State start, const Goal &goal, SearchResult &result){
+	if(puzzle.items.size() > LearnedHeuristic::MAX_ITEMS){
+		searchAStar(puzzle, start, goal, result);
+		return;
+	}
+	if(!reachable(puzzle, start, goal))
+		return;
+	prepareHeuristics(puzzle, goal, options.heuristics);
+	learned.prepare(puzzle, goal);
+	Move move;
+	for(State s = start; !goal.matches(s); s ^= move.carried){
+		if(!lookahead(puzzle, s, goal, move, result)){
+			result.moves.clear();
+			return;
+		}
+		if(options.trace >= 1){
+			*options.log << "Move:\t";
+			puzzle.write(*options.log, move);
+			*options.log << endl;
+		}
+		result.moves.push_back(move);
+	}
+	result.found = true;
+	result.cost = 0;
+	for(unsigned int i = 0; i < result.moves.size(); ++i)
+		result.cost += result.moves[i].cost();
+}
+
+///@brief A* from the current state for at most SearchOptions::lookahead expansions, then a move towards the best of its frontier
+///
+///Any path from the current state to the goal leaves through the frontier, so
+///the smallest f there less the cost of reaching a state expanded is a lower bound
+///on that state's cost to the goal. Each state expanded learns it, as in real-time
+///adaptive A*, which is what stops the moves from going round in circles.
+///@return False if the current state is a goal, or the goal is unreachable or farther than the learned costs hold
+bool SolverContext::lookahead(const Puzzle &puzzle, State current, const Goal &goal, Move &move, SearchResult &result){
+	StateTable &generated = tables[0];
+	Frontier &frontier = options.frontier == FRONTIER_HEAP ? (Frontier &)heapFrontier
+			: options.frontier == FRONTIER_BUCKET ? (Frontier &)bucketFrontier : (Frontier &)multimapFrontier;
+	const vector <Heuristic> &heuristics = options.heuristics;
+	nodes.reset();
+	generated.clear();
+	frontier.clear();
+	expandedNodes.clear();
+	if(goal.matches(current))
+		return false;
+
+	int h = std::max(estimate(puzzle, current, goal, heuristics, 0, (unsigned int)heuristics.size(), result), learned.h(current));
+	PSNode * node = nodes.allocate(current, NULL, Move(), h);
+	node->priority = h * WEIGHT_SCALE;
+	generated.insert(node);
+	frontier.push(node);
+	++result.generated;
+	PSNode * best = NULL;
+	unsigned int budget = std::max(options.lookahead, 1u);
+	while(!frontier.empty()){
+		node = frontier.pop();
+		if(goal.matches(node->state) or expandedNodes.size() == budget){
+			best = node;
+			break;
+		}
+		expandedNodes.push_back(node);
+		++result.expanded;
+		puzzle.nextMoves(node->state, moves);
+		for(unsigned int i = 0; i < moves.size(); ++i){
+			if(node->parent != NULL and moves[i] == node->move.inverse())
+				continue;
+			State child = node->state ^ moves[i].carried;
+			PSNode * workNode = generated.find(child, result.lookups);
+			if(workNode != NULL){
+				workNode->updateCostCond(node->cost2reach + moves[i].cost(), node, moves[i], frontier);
+			}else{
+				h = std::max(estimate(puzzle, child, goal, heuristics, 0, (unsigned int)heuristics.size(), result), learned.h(child));
+				workNode = nodes.allocate(child, node, moves[i], h);
+				workNode->priority = (workNode->cost2reach + h) * WEIGHT_SCALE;
+				generated.insert(workNode);
+				frontier.push(workNode);
+				++result.generated;
+			}
+			node->children.push_back(ChildPair(moves[i], workNode));
+		}
+	}
+
+	//with no frontier left every state the goal could be reached through was expanded
+	int f = best == NULL ? (int)LearnedHeuristic::UNREACHABLE : best->cost2reach + best->projectedCost;
+	for(unsigned int i = 0; i < expandedNodes.size(); ++i)
+		learned.learn(expandedNodes[i]->state, f - expandedNodes[i]->cost2reach);
+	if(f >= LearnedHeuristic::UNREACHABLE)
+		return false;
+	while(best->parent->parent != NULL)
+		best = best->parent;
+	move = best->move;
+	return true;
+}
+
+bool SolverContext::realTimeMove(const Puzzle &puzzle, State current, const Goal &goal, Move &move){
+	if(!puzzle.legal(current))
+		return false;
+	SearchResult result;
+	prepareHeuristics(puzzle, goal, options.heuristics);
+	learned.prepare(puzzle, goal);
+	bool rval = lookahead(puzzle, current, goal, move, result);
+	recycle();
+	return rval;
+}
+
+bool SolverContext::nextMove(const Puzzle &puzzle, State start, State goal, Move &move){
+	if(paths.prepare(puzzle))
+		return paths.next(start, goal, move);
+	SearchResult result;
+	solve(puzzle, start, Goal(goal, puzzle.all()), result);
+	if(result.moves.empty())
+		return false;
+	move = result.moves[0];
+	return true;
+}
+
+SearchResult search(const Puzzle &puzzle, State start, const Goal &goal, const SearchOptions &options){
+	SolverContext context;
+	context.options = options;
+	return context.solve(puzzle, start, goal);
+}
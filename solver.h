@@ -0,0 +1,228 @@
+/**
+ * @file solver.h
+ * @brief Embeddable solver for river crossing puzzles.
+ *
+ * A SolverContext keeps its node storage, state tables and frontiers between
+ * calls, so a program solving many queries links the solver directly instead
+ * of starting a process and parsing its output for each one:
+ * @code
+ * Puzzle puzzle;
+ * SolverContext solver;
+ * SearchResult result = solver.solve(puzzle, puzzle.start, Goal(puzzle.goal, puzzle.all()));
+ * @endcode
+ */
+
+#ifndef FWDC_SOLVER_H
+#define FWDC_SOLVER_H
+
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "bdd.h"
+#include "bitmap.h"
+#include "frontier.h"
+#include "heuristics.h"
+#include "hierarchy.h"
+#include "pathdb.h"
+#include "puzzle.h"
+#include "tables.h"
+
+///@brief Search algorithms the solver can run
+enum Algorithm{
+	ALGORITHM_ASTAR,///<A*, optimal
+	ALGORITHM_WEIGHTED,///<A* with the heuristic scaled by SearchOptions::weight, bounded suboptimal
+	ALGORITHM_IDA,///<iterative deepening A*, optimal and needs memory only for the current path
+	ALGORITHM_BFS,///<breadth first search, optimal since every move costs the same
+	ALGORITHM_BIDIRECTIONAL,///<breadth first from both the start and the goal, meeting in the middle
+	ALGORITHM_PARALLEL,///<breadth first with each layer expanded by SearchOptions::threads threads
+	ALGORITHM_BITMAP,///<breadth first over bitmaps of every state, a whole layer per step, see bitmap.h
+	ALGORITHM_BDD,///<breadth first over sets of states held as binary decision diagrams, see bdd.h
+	ALGORITHM_EPEA,///<enhanced partial expansion A*, optimal and only generates the children with the node's f
+	ALGORITHM_LAZY,///<A* evaluating all but the first heuristic only for nodes at the top of the frontier, optimal
+	ALGORITHM_PATHS,///<first moves looked up in a compressed path database, optimal, see pathdb.h
+	ALGORITHM_HIERARCHY,///<bidirectional search of a contraction hierarchy, optimal, see hierarchy.h
+	ALGORITHM_REALTIME///<real-time adaptive A*, a move after each lookahead of SearchOptions::lookahead expansions, not optimal
+};
+
+///@brief Frontier implementations for the A* family
+enum FrontierKind{
+	FRONTIER_MULTIMAP,///<MultimapFrontier
+	FRONTIER_HEAP,///<HeapFrontier
+	FRONTIER_BUCKET///<BucketFrontier
+};
+
+///@brief How a search is run
+struct SearchOptions{
+	Algorithm algorithm;///<which search to run
+	FrontierKind frontier;///<frontier used by A* and weighted A*
+	double weight;///<heuristic weight for weighted A*
+	int trace;///<0 prints nothing, 1 prints expansions, 2 also prints the frontier and every generated node
+	unsigned int threads;///<worker threads for the parallel search and for preprocessing contraction hierarchies
+	unsigned int lookahead;///<states the real-time search expands before each move, at least 1
+	bool filter;///<put a BloomFilter in front of the tables of generated states
+	HugePages hugePages;///<whether the node arena and state tables use huge pages
+	std::vector <Heuristic> heuristics;///<A*, weighted and lazy A* take the largest, lazy A* evaluates them in this order
+	std::string landmarkFile;///<where the landmark tables are mapped from or saved to, empty to build them in memory
+	std::string hierarchyFile;///<where the contraction hierarchy is mapped from or saved to, empty to build it in memory
+	std::ostream * log;///<where the trace goes
+
+	SearchOptions(){
+		algorithm = ALGORITHM_ASTAR;
+		frontier = FRONTIER_MULTIMAP;
+		weight = 2;
+		trace = 0;
+		threads = 1;
+		lookahead = 16;
+		filter = false;
+		hugePages = HUGE_PAGES_OFF;
+		heuristics.assign(1, HEURISTIC_COUNTING);
+		log = &std::cout;
+	}
+
+	///@brief Can the algorithm use every heuristic listed? Partial expansion works from counting alone
+	bool heuristicsApply()const{
+		for(std::size_t i = 0; i < heuristics.size(); ++i){
+			if(algorithm == ALGORITHM_EPEA and heuristics[i] != HEURISTIC_COUNTING)
+				return false;
+		}
+		return true;
+	}
+};
+
+///@brief What a search found
+struct SearchResult{
+	bool found;///<was a goal state reached
+	int cost;///<cost of the path found, -1 if none
+	std::vector <Move> moves;///<the moves from the start to the goal
+	unsigned long expanded;///<number of nodes expanded
+	unsigned long generated;///<number of nodes generated, the start included
+	LookupStats lookups;///<duplicate checks of generated states, with how the filter fared if there was one
+	unsigned long evaluations;///<heuristic evaluations made by the A* family
+	unsigned long evaluationsSaved;///<evaluations lazy A* skipped against evaluating every heuristic of every generated node
+
+	SearchResult(){
+		found = false;
+		cost = -1;
+		expanded = 0;
+		generated = 0;
+		evaluations = 0;
+		evaluationsSaved = 0;
+	}
+};
+
+/**
+ * @brief Reusable state for running searches
+ *
+ * Everything a search allocates is kept when it finishes and reused by the next
+ * one. A context is not thread safe, use one per thread.
+ */
+class SolverContext{
+public:
+	SearchOptions options;///<how solve() searches
+
+	SolverContext(){
+	}
+
+	///@brief Search for a path from a start state to a goal
+	///@param puzzle The puzzle to solve
+	///@param start The state to start from
+	///@param goal The states to reach
+	///@return The path found, if any, and search statistics
+	SearchResult solve(const Puzzle &puzzle, State start, const Goal &goal){
+		SearchResult result;
+		solve(puzzle, start, goal, result);
+		return result;
+	}
+
+	///@brief Search for a path, reusing the memory of an existing result
+	void solve(const Puzzle &puzzle, State start, const Goal &goal, SearchResult &result);
+
+	///@brief The first move of an optimal path from one state to another
+	///
+	///Looked up in a compressed path database built the first time the puzzle is
+	///queried, or for puzzles too large for one the first move of a search made
+	///with the current options.
+	///@return False if there is no path, or start and goal are the same state
+	bool nextMove(const Puzzle &puzzle, State start, State goal, Move &move);
+
+	///@brief A move towards a goal chosen after a lookahead of SearchOptions::lookahead expansions
+	///
+	///The time taken depends on the lookahead, not on the size of the puzzle. What
+	///the lookahead learns about the states it expanded is kept, so making the move
+	///and asking again from where it leads reaches the goal if it can be reached.
+	///Nothing is learned for puzzles of more than LearnedHeuristic::MAX_ITEMS items,
+	///and the moves may then go round in circles.
+	///
+	///At worst the goal can't be reached: each call still returns within its lookahead,
+	///but no call says so until the costs learned for every state of the component
+	///have climbed to LearnedHeuristic::UNREACHABLE, which takes on the order of that
+	///many lookaheads per state. solve() checks reachability first, callers walking
+	///a large puzzle move by move should too, or bound the moves they make.
+	///@return False if there is no move: the state is a goal, illegal or can't reach the goal
+	bool realTimeMove(const Puzzle &puzzle, State current, const Goal &goal, Move &move);
+
+private:
+	///@brief A child found by a worker thread of the parallel search, merged into the table afterwards
+	struct Candidate{
+		State state;
+		PSNode * parent;
+		Move move;
+	};
+
+	NodeArena nodes;
+	StateTable tables[2];///<generated states, the second is for the backward half of bidirectional search
+	MultimapFrontier multimapFrontier;
+	HeapFrontier heapFrontier;
+	BucketFrontier bucketFrontier;
+	std::vector <PSNode *> layers[2];
+	std::vector <PSNode *> next;
+	std::vector <Move> moves;
+	std::vector <std::vector <Candidate> > candidates;
+	std::vector <LookupStats> sliceLookups;///<lookups made by each worker of the parallel search
+	std::vector <State> path;
+	StateBitmap legalStates;
+	StateBitmap goalStates;
+	StateBitmap visitedStates;
+	std::vector <StateBitmap> bitmapLayers;///<every layer of the bitmap search so far without the farmer's bit, see dropFarmer()
+	StateBitmap bitmapLayer;///<the layer the bitmap search is expanding
+	StateBitmap bitmapNext;///<and the one it is expanding into
+	StateBitmap bitmapScratch;///<states partway through a crossing in the bitmap search
+	BddManager bdd;
+	std::vector <BddRef> bddLayers;///<every layer of the BDD search so far
+	std::vector <BddRef> bddRoots;///<the BDDs kept when the search collects garbage
+	PatternDatabase patterns;
+	LandmarkTable landmarks;
+	LearnedHeuristic learned;
+	std::vector <PSNode *> expandedNodes;///<the nodes an A* search learning costs expanded, in order
+	PathDatabase paths;
+	ContractionHierarchy hierarchy;
+
+	SolverContext(const SolverContext &);
+	SolverContext &operator=(const SolverContext &);
+
+	void recycle();
+	void prepareHeuristics(const Puzzle &puzzle, const Goal &goal, const std::vector <Heuristic> &heuristics);
+	void searchAStar(const Puzzle &puzzle, State start, const Goal &goal, SearchResult &result);
+	int estimate(const Puzzle &puzzle, State s, const Goal &goal, const std::vector <Heuristic> &heuristics,
+			unsigned int first, unsigned int end, SearchResult &result);
+	void searchIDA(const Puzzle &puzzle, State start, const Goal &goal, SearchResult &result);
+	int visitIDA(const Puzzle &puzzle, const Goal &goal, int g, int bound, SearchResult &result);
+	void searchBFS(const Puzzle &puzzle, State start, const Goal &goal, SearchResult &result);
+	void searchBidirectional(const Puzzle &puzzle, State start, const Goal &goal, SearchResult &result);
+	void searchParallel(const Puzzle &puzzle, State start, const Goal &goal, SearchResult &result);
+	void searchBitmap(const Puzzle &puzzle, State start, const Goal &goal, SearchResult &result);
+	void searchBdd(const Puzzle &puzzle, State start, const Goal &goal, SearchResult &result);
+	void searchPaths(const Puzzle &puzzle, State start, const Goal &goal, SearchResult &result);
+	void searchHierarchy(const Puzzle &puzzle, State start, const Goal &goal, SearchResult &result);
+	void searchRealTime(const Puzzle &puzzle, State start, const Goal &goal, SearchResult &result);
+	bool reachable(const Puzzle &puzzle, State start, const Goal &goal);
+	bool lookahead(const Puzzle &puzzle, State current, const Goal &goal, Move &move, SearchResult &result);
+	static void expandSlice(const Puzzle &puzzle, const StateTable &seen, const std::vector <PSNode *> &layer,
+			std::size_t begin, std::size_t end, std::vector <Candidate> &out, LookupStats &stats);
+};
+
+///@brief Search for a path from a start state to a goal with a one off context
+SearchResult search(const Puzzle &puzzle, State start, const Goal &goal, const SearchOptions &options);
+
+#endif
@@ -0,0 +1,114 @@
+/**
+ * @file state.cpp
+ * @brief Formatting and parsing of the bracket notation.
+ */
+
+#include "state.h"
+
+std::to_chars_result formatState(char * first, char * last, unsigned long bits, const ItemNames &names){
+	std::to_chars_result rval = {last, std::errc::value_too_large};
+	if(first == last)
+		return rval;
+	*first++ = '[';
+	for(int bank = 1; bank >= 0; --bank){
+		bool any = false;
+		for(unsigned int i = 0; i < names.count; ++i){
+			if((int)((bits >> i) & 1) != bank)
+				continue;
+			if(any and names.separator){
+				if(first == last)
+					return rval;
+				*first++ = names.separator;
+			}
+			if(last - first < names.lengths[i])
+				return rval;
+			std::memcpy(first, names.names[i], names.lengths[i]);
+			first += names.lengths[i];
+			any = true;
+		}
+		if(last - first < 2)
+			return rval;
+		*first++ = bank ? '|' : ']';
+		if(bank)
+			*first++ = '|';
+	}
+	rval.ptr = first;
+	rval.ec = std::errc();
+	return rval;
+}
+
+std::from_chars_result parseState(const char * first, const char * last, unsigned long &bits, const ItemNames &names){
+	std::from_chars_result rval = {first, std::errc::invalid_argument};
+	const char * pos = first;
+	unsigned long seen = 0, left = 0;
+	if(pos == last or *pos++ != '[')
+		return rval;
+	for(int bank = 1; bank >= 0; --bank){
+		bool any = false;
+		while(pos != last and *pos != '|' and *pos != ']'){
+			if(any and names.separator){
+				if(*pos++ != names.separator)
+					return rval;
+			}
+			//longest name matching here, so no name has to be a prefix free code
+			int match = -1;
+			for(unsigned int i = 0; i < names.count; ++i){
+				if(last - pos >= names.lengths[i] and std::memcmp(pos, names.names[i], names.lengths[i]) == 0
+						and (match < 0 or names.lengths[i] > names.lengths[match]))
+					match = i;
+			}
+			if(match < 0 or names.lengths[match] == 0 or (seen >> match) & 1)
+				return rval;
+			seen |= 1ul << match;
+			if(bank)
+				left |= 1ul << match;
+			pos += names.lengths[match];
+			any = true;
+		}
+		if(bank){
+			if(last - pos < 2 or pos[0] != '|' or pos[1] != '|')
+				return rval;
+			pos += 2;
+		}else if(pos == last or *pos++ != ']'){
+			return rval;
+		}
+	}
+	if(seen != (names.count >= 64 ? ~0ul : (1ul << names.count) - 1))
+		return rval;
+	bits = left;
+	rval.ptr = pos;
+	rval.ec = std::errc();
+	return rval;
+}
+
+std::to_chars_result formatMove(char * first, char * last, const Move &move, const ItemNames &names){
+	std::to_chars_result rval = {last, std::errc::value_too_large};
+	if(last - first < 3)
+		return rval;
+	if(move.toLeft)
+		*first++ = '<';
+	*first++ = '-';
+	bool any = false;
+	for(unsigned int i = 0; i < names.count; ++i){
+		if(!((move.carried >> i) & 1))
+			continue;
+		if(any and names.separator){
+			if(first == last)
+				return rval;
+			*first++ = names.separator;
+		}
+		if(last - first < names.lengths[i])
+			return rval;
+		std::memcpy(first, names.names[i], names.lengths[i]);
+		first += names.lengths[i];
+		any = true;
+	}
+	if(last - first < (move.toLeft ? 1 : 2))
+		return rval;
+	*first++ = '-';
+	if(!move.toLeft)
+		*first++ = '>';
+	rval.ptr = first;
+	rval.ec = std::errc();
+	return rval;
+}
@@ -0,0 +1,324 @@
+/**
+ * @file state.h
+ * @brief Packed states, moves and the bracket notation of river crossing puzzles.
+ */
+
+#ifndef FWDC_STATE_H
+#define FWDC_STATE_H
+
+#include <charconv>
+#include <cstring>
+#include <ostream>
+#include <string>
+#include <vector>
+
+///@brief Packed puzzle state, bit i set means item i is on the left bank of the river
+typedef unsigned int State;
+
+/**
+ * @brief Table of item names used to format and parse states of a river crossing puzzle
+ * @note The table only points at the names, whoever builds it keeps them alive.
+ */
+struct ItemNames{
+	const char * const * names;///<name of each item, the farmer first
+	const unsigned char * lengths;///<length of each name, so formatting never has to measure
+	unsigned int count;///<number of items
+	char separator;///<written between items on the same bank, 0 if names are single characters
+};
+
+///@brief Write a packed state in the bracket notation, e.g. "[FWD||C]", without allocating
+///@param first Start of the output buffer
+///@param last One past the end of the output buffer
+///@param bits Packed state, bit i set means item i is on the left bank
+///@param names Names of the items in bit order
+///@return One past the last character written, or last and value_too_large if it does not fit
+std::to_chars_result formatState(char * first, char * last, unsigned long bits, const ItemNames &names);
+
+///@brief Read a packed state in the bracket notation written by formatState() without allocating
+///@param first Start of the text
+///@param last One past the end of the text
+///@param bits Set to the packed state, untouched on failure
+///@param names Names of the items in bit order
+///@return One past the closing bracket, or first and invalid_argument if the text is not a state
+///@note Items may be listed in any order within a bank, but each must appear exactly once.
+std::from_chars_result parseState(const char * first, const char * last, unsigned long &bits, const ItemNames &names);
+
+/**
+ * @brief A single river crossing: the items carried in the boat and the direction it goes
+ * @note The farmer rows every crossing so his bit is always part of carried.
+ */
+class Move{
+public:
+	State carried;///<packed bitmask of the items in the boat, see FWDCstate::packed()
+	bool toLeft;///<true if the boat crosses to the left bank of the river
+
+	///@brief Construct an empty move (the farmer crossing to the right alone)
+	Move(){
+		carried = 1;
+		toLeft = false;
+	}
+
+	///@brief Construct a move from the items in the boat and its direction
+	///@param items packed bitmask of the items in the boat, farmer included
+	///@param left does the boat cross to the left bank?
+	Move(State items, bool left){
+		carried = items;
+		toLeft = left;
+	}
+
+	bool operator==(const Move &other) const{
+		return carried == other.carried and toLeft == other.toLeft;
+	}
+
+	bool operator!=(const Move &other) const{
+		return carried != other.carried or toLeft != other.toLeft;
+	}
+
+	///@brief The move that carries the same items back the other way
+	Move inverse()const{
+		return Move(carried, !toLeft);
+	}
+
+	///@brief Cost of making this crossing, every crossing takes one move
+	int cost()const{
+		return 1;
+	}
+
+	///@brief Write the move as e.g. "<-FD-" or "-FD->" without allocating
+	///@return One past the last character written, or last and value_too_large if it does not fit
+	std::to_chars_result toChars(char * first, char * last)const{
+		static const char names[] = "FWDC";
+		std::to_chars_result rval = {last, std::errc::value_too_large};
+		if(last - first < 8)
+			return rval;
+		if(toLeft)
+			*first++ = '<';
+		*first++ = '-';
+		for(int i = 0; i < 4; ++i){
+			if(carried & (1 << i))
+				*first++ = names[i];
+		}
+		*first++ = '-';
+		if(!toLeft)
+			*first++ = '>';
+		rval.ptr = first;
+		rval.ec = std::errc();
+		return rval;
+	}
+
+	///@brief Get a string representation of the move, e.g. "<-FD-" or "-FD->"
+	std::string toString()const{
+		char buffer[8];
+		return std::string(buffer, toChars(buffer, buffer + sizeof(buffer)).ptr);
+	}
+};
+
+/**
+ * @brief Farmer Wolf Duck and Corn game state
+ */
+class FWDCstate{
+public:
+	bool FL;///<is farmer on left bank of the river
+	bool WL;///<is wolf on left bank of the river
+	bool DL;///<is duck on left bank of the river
+	bool CL;///<is corn on left bank of the river
+
+	///@brief Construct a new state with all items on the right bank of the river
+	FWDCstate(){
+		FL = 0;
+		WL = 0;
+		DL = 0;
+		CL = 0;
+	}
+
+	///@brief Construct a new state with some items on the left bank of the river
+	///@param FF Is the farmer on the left bank?
+	///@param WW Is the wolf on the left bank?
+	///@param DD is the duck on the left bank?
+	///@param CC is the corn on the left bank?
+	FWDCstate(bool FF, bool WW, bool DD, bool CC){
+		FL=FF;
+		WL=WW;
+		DL=DD;
+		CL=CC;
+	}
+	///@brief Less than operator for placement in ordered data structures
+	///@note neccessary for use as an STL map or set key
+	bool operator<(const FWDCstate &other) const{
+		if(FL != other.FL){
+			return other.FL;
+		}else if(WL != other.WL){
+			return other.WL;
+		}else if(DL != other.DL){
+			return other.DL;
+		}else if(CL != other.CL){
+			return other.CL;
+		}else
+			return false;
+	}
+
+	bool operator==(const FWDCstate &other) const{
+		return FL == other.FL and WL == other.WL and DL == other.DL and CL == other.CL;
+	}
+
+	bool operator!=(const FWDCstate &other) const{
+		return FL != other.FL or WL != other.WL or DL != other.DL or CL != other.CL;
+	}
+
+	///@brief Pack the state into a bitmask, bit set means the item is on the left bank
+	///@return farmer in bit 0, wolf in bit 1, duck in bit 2 and corn in bit 3
+	unsigned char packed()const{
+		return (unsigned char)((int)FL | (int)WL << 1 | (int)DL << 2 | (int)CL << 3);
+	}
+
+	///@brief Construct a state from the bitmask returned by packed()
+	static FWDCstate unpack(unsigned char bits){
+		return FWDCstate(bits & 1, bits & 2, bits & 4, bits & 8);
+	}
+
+	///@brief Get the state reached by making a move from this one
+	///@note Legality is not checked, use nextMoves() for legal moves
+	FWDCstate apply(const Move &move)const{
+		return unpack((unsigned char)(packed() ^ move.carried));
+	}
+
+	bool isWinning()const{
+		return FL and WL and DL and CL;
+	}
+
+	///@brief Computes a heuristic for all items to reach the left bank
+	int h()const{
+		return /*(int)!FL+*/(int)!WL+(int)!DL+(int)!CL;
+	}
+
+	///@brief Can the farmer and wolf be moved to the other bank next turn without creating an illegal state
+	bool canMoveFW()const{
+		return FL == WL and DL != CL;
+	}
+	///@brief Can the farmer and corn be moved to the other bank next turn without creating an illegal state
+	bool canMoveFC()const{
+		return FL == CL and WL != DL;
+	}
+	///@brief Can just the farmer be moved to the other bank next turn without creating an illegal state
+	bool canMoveF()const{
+		return DL != CL and WL != DL;
+	}
+	///@brief Can the farmer and duck be moved to the other bank next turn without creating an illegal state
+	bool canMoveFD()const{
+		return FL == DL;
+	}
+	///@brief Get all legal moves that can be made from this state
+	///@return a vector of moves, in the same order as nextStates()
+	std::vector <Move> nextMoves()const{
+		std::vector <Move> rvec;
+		if(canMoveFW())
+			rvec.push_back(Move(1 | 2, !FL));
+		if(canMoveFD())
+			rvec.push_back(Move(1 | 4, !FL));
+		if(canMoveFC())
+			rvec.push_back(Move(1 | 8, !FL));
+		if(canMoveF())
+			rvec.push_back(Move(1, !FL));
+
+		return rvec;
+	}
+	///@brief Get all legal game states that can be expanded from this one
+	///@return a vector of states one move from this one
+	std::vector <FWDCstate> nextStates()const{
+		std::vector <Move> moves = nextMoves();
+		std::vector <FWDCstate> rvec;
+		for(unsigned int i = 0; i < moves.size(); ++i)
+			rvec.push_back(apply(moves[i]));
+
+		return rvec;
+	}
+	///@brief Length of the bracket notation of any state
+	static const int TEXT_LENGTH = 8;
+
+	///@brief The bracket notation of every state, indexed by packed()
+	static const char * text(unsigned char bits){
+		static const char * const table[16] = {
+			"[||FWDC]",
+			"[F||WDC]",
+			"[W||FDC]",
+			"[FW||DC]",
+			"[D||FWC]",
+			"[FD||WC]",
+			"[WD||FC]",
+			"[FWD||C]",
+			"[C||FWD]",
+			"[FC||WD]",
+			"[WC||FD]",
+			"[FWC||D]",
+			"[DC||FW]",
+			"[FDC||W]",
+			"[WDC||F]",
+			"[FWDC||]",
+		};
+		return table[bits & 15];
+	}
+
+	///@brief The item names of the puzzle, for use with formatState()
+	static const ItemNames &names(){
+		static const char * const table[4] = {"F", "W", "D", "C"};
+		static const unsigned char lengths[4] = {1, 1, 1, 1};
+		static const ItemNames rval = {table, lengths, 4, 0};
+		return rval;
+	}
+
+	///@brief Write the state in the bracket notation, e.g. "[FWD||C]", without allocating
+	///@return One past the last character written, or last and value_too_large if it does not fit
+	std::to_chars_result toChars(char * first, char * last)const{
+		std::to_chars_result rval = {last, std::errc::value_too_large};
+		if(last - first < TEXT_LENGTH)
+			return rval;
+		std::memcpy(first, text(packed()), TEXT_LENGTH);
+		rval.ptr = first + TEXT_LENGTH;
+		rval.ec = std::errc();
+		return rval;
+	}
+
+	///@brief Get a string representation of the problem state.
+	std::string toString()const{
+		return std::string(text(packed()), TEXT_LENGTH);
+	}
+
+	///@brief Read a state in the bracket notation written by toString(), e.g. "[FWD||C]"
+	///@param first Start of the text
+	///@param last One past the end of the text
+	///@param state Set to the state read, untouched on failure
+	///@return One past the closing bracket, or first and invalid_argument if the text is not a state
+	static std::from_chars_result fromChars(const char * first, const char * last, FWDCstate &state){
+		unsigned long bits = 0;
+		std::from_chars_result rval = parseState(first, last, bits, names());
+		if(rval.ec == std::errc())
+			state = unpack((unsigned char)bits);
+		return rval;
+	}
+};
+
+///@brief Write a state to a stream in the bracket notation without building a string
+inline std::ostream &operator<<(std::ostream &out, const FWDCstate &state){
+	return out.write(FWDCstate::text(state.packed()), FWDCstate::TEXT_LENGTH);
+}
+
+///@brief Write a move to a stream without building a string
+inline std::ostream &operator<<(std::ostream &out, const Move &move){
+	char buffer[8];
+	return out.write(buffer, move.toChars(buffer, buffer + sizeof(buffer)).ptr - buffer);
+}
+
+
+///@brief Write a move as e.g. "<-F,Duck-" using a puzzle's item names, without allocating
+///@return One past the last character written, or last and value_too_large if it does not fit
+std::to_chars_result formatMove(char * first, char * last, const Move &move, const ItemNames &names);
+
+///@brief Count the items set in a packed state
+inline int countItems(State bits){
+	int rval = 0;
+	for(; bits; bits &= bits - 1)
+		++rval;
+	return rval;
+}
+
+#endif
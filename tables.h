@@ -0,0 +1,403 @@
+/**
+ * @file tables.h
+ * @brief Node storage and the table of generated states used by the searches.
+ */
+
+#ifndef FWDC_TABLES_H
+#define FWDC_TABLES_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "frontier.h"
+#include "pages.h"
+
+///@brief Counts of StateTable lookups, to judge how well its filter works
+struct LookupStats{
+	unsigned long lookups;///<states looked up
+	unsigned long filtered;///<lookups the filter answered without probing the table
+	unsigned long falsePositives;///<lookups the filter let through for states that weren't in the table
+
+	LookupStats(){
+		lookups = 0;
+		filtered = 0;
+		falsePositives = 0;
+	}
+
+	///@brief Add the counts of another set of lookups
+	void add(const LookupStats &other){
+		lookups += other.lookups;
+		filtered += other.filtered;
+		falsePositives += other.falsePositives;
+	}
+
+	///@brief Fraction of the lookups for absent states that the filter failed to answer
+	double falsePositiveRate()const{
+		unsigned long absent = filtered + falsePositives;
+		return absent == 0 ? 0 : (double)falsePositives / absent;
+	}
+};
+
+/**
+ * @brief Blocked Bloom filter over packed states
+ *
+ * Each state sets HASHES bits within a single 64 byte block, so a query reads one
+ * cache line where a miss in StateTable may probe several. A block is stamped
+ * with the epoch it was written in like the table's slots, and a block from an
+ * older epoch reads as empty, so the filter is cleared along with its table.
+ */
+class BloomFilter{
+public:
+	static const unsigned int HASHES = 3;///<bits set per state
+	static const unsigned int SLOTS_PER_BLOCK = 32;///<table slots per block, at most 16 states for 480 bits
+
+	BloomFilter(){
+		shift = 64;
+	}
+
+	///@brief Drop every state and size the filter for a table with a number of slots
+	void resize(std::size_t slots){
+		std::size_t count = 2;//so the block index always takes at least one bit of the hash
+		while(count * SLOTS_PER_BLOCK < slots)
+			count *= 2;
+		Block empty = {};
+		blocks.assign(count, empty);
+		for(shift = 64; ((std::size_t)1 << (64 - shift)) < count; --shift)
+			;
+	}
+
+	///@brief Could a state have been added in an epoch?
+	///@return False only if it certainly wasn't
+	bool mayContain(State state, unsigned int epoch)const{
+		std::uint64_t h = (std::uint64_t)state * MULTIPLIER;
+		const Block &block = blocks[h >> shift];
+		if(block.words[0] != epoch)
+			return false;
+		h = remix(h);
+		for(unsigned int i = 0; i < HASHES; ++i, h <<= BITS_PER_HASH){
+			unsigned int v = (unsigned int)(h >> (64 - BITS_PER_HASH));
+			if(!(block.words[1 + (v * 15 >> BITS_PER_HASH)] & 1u << (v & 31)))
+				return false;
+		}
+		return true;
+	}
+
+	///@brief Start loading the block of a state, see StateTable::prefetch()
+	void prefetch(State state)const{
+		::prefetch(&blocks[(std::uint64_t)state * MULTIPLIER >> shift]);
+	}
+
+	///@brief Add a state in an epoch
+	void add(State state, unsigned int epoch){
+		std::uint64_t h = (std::uint64_t)state * MULTIPLIER;
+		Block &block = blocks[h >> shift];
+		if(block.words[0] != epoch){
+			Block empty = {};
+			block = empty;
+			block.words[0] = epoch;
+		}
+		h = remix(h);
+		for(unsigned int i = 0; i < HASHES; ++i, h <<= BITS_PER_HASH){
+			unsigned int v = (unsigned int)(h >> (64 - BITS_PER_HASH));
+			block.words[1 + (v * 15 >> BITS_PER_HASH)] |= 1u << (v & 31);
+		}
+	}
+
+	///@brief Mark every block empty, for when the epochs wrap around
+	void wipe(){
+		for(std::size_t i = 0; i < blocks.size(); ++i)
+			blocks[i].words[0] = 0;
+	}
+
+	bool empty()const{
+		return blocks.empty();
+	}
+
+	///@brief Drop the filter and its memory, later resize() calls allocate with a huge page policy
+	void release(HugePages policy = HUGE_PAGES_OFF){
+		BlockVector(PageAllocator <Block>(policy)).swap(blocks);
+		shift = 64;
+	}
+
+private:
+	static const std::uint64_t MULTIPLIER = 0xD6E8FEB86659FD93ull;///<first hash, its top bits pick the block
+	static const unsigned int BITS_PER_HASH = 10;///<bits of the second hash picking each position, the word from the high ones and the bit from the low five
+
+	///@brief The epoch stamp and 15 words of bits
+	struct alignas(64) Block{
+		std::uint32_t words[16];
+	};
+	typedef std::vector <Block, PageAllocator <Block> > BlockVector;
+
+	BlockVector blocks;
+	int shift;///<64 - log2(blocks.size())
+
+	///@brief Second hash for the bit positions, since the block index used the top bits of the first
+	static std::uint64_t remix(std::uint64_t h){
+		return (h ^ (h >> 29)) * 0x9E3779B97F4A7C15ull;
+	}
+};
+
+/**
+ * @brief Open addressing hash table from packed states to their problem space graph nodes
+ *
+ * Linear probing over a power of two number of slots that is kept at most half
+ * full, so looking up a state that was never generated stops at a nearby empty
+ * slot. Every slot is stamped with the epoch it was filled in and only slots of
+ * the current epoch are occupied, so clearing the table for the next search
+ * just starts a new epoch and keeps the slots as they are.
+ *
+ * With setFilter() a BloomFilter sits in front of the slots, so looking up a
+ * state that was never generated, the common case on large puzzles, usually
+ * reads one filter block instead of probing the much larger slot array.
+ */
+class StateTable{
+public:
+	StateTable(){
+		count = 0;
+		shift = 64;
+		epoch = 1;
+	}
+
+	///@brief Find the node generated for a state
+	///@return The node, or NULL if the state hasn't been generated
+	PSNode * find(State state)const{
+		if(count == 0 or (!filter.empty() and !filter.mayContain(state, epoch)))
+			return NULL;
+		return probe(state);
+	}
+
+	///@brief Find the node generated for a state, counting how the lookup went
+	PSNode * find(State state, LookupStats &stats)const{
+		++stats.lookups;
+		if(count == 0)
+			return NULL;
+		if(!filter.empty() and !filter.mayContain(state, epoch)){
+			++stats.filtered;
+			return NULL;
+		}
+		PSNode * node = probe(state);
+		if(node == NULL and !filter.empty())
+			++stats.falsePositives;
+		return node;
+	}
+
+	///@brief Start loading the memory a lookup of a state reads first
+	///@note Issue this for a batch of states before looking any of them up, so their cache misses overlap
+	void prefetch(State state)const{
+		if(!filter.empty())
+			filter.prefetch(state);
+		else if(count != 0)
+			::prefetch(&slots[slot(state)]);
+	}
+
+	///@brief Add a node for a state that hasn't been generated yet
+	void insert(PSNode * node){
+		if(2 * (count + 1) > slots.size())
+			grow();
+		place(node);
+		if(!filter.empty())
+			filter.add(node->state, epoch);
+		++count;
+	}
+
+	///@brief Put a Bloom filter in front of the table, or take it away
+	void setFilter(bool on){
+		if(on == !filter.empty())
+			return;
+		if(on)
+			rebuildFilter();
+		else
+			filter.release(slots.get_allocator().policy);
+	}
+
+	///@brief Choose whether large slot arrays use huge pages, dropping the slots if that changes
+	///@note Only call this between searches, with the table cleared
+	void setHugePages(HugePages policy){
+		if(policy == slots.get_allocator().policy)
+			return;
+		SlotVector(PageAllocator <Slot>(policy)).swap(slots);
+		count = 0;
+		shift = 64;
+		bool filtered = !filter.empty();
+		filter.release(policy);
+		if(filtered)
+			rebuildFilter();
+	}
+
+	///@brief Number of states in the table
+	std::size_t size()const{
+		return count;
+	}
+
+	///@brief Forget every state in constant time, keeping the slots for reuse
+	void clear(){
+		if(count == 0)
+			return;
+		count = 0;
+		if(++epoch == 0){
+			//the stamps wrapped around, so old slots could pass for new ones
+			for(std::size_t i = 0; i < slots.size(); ++i)
+				slots[i].epoch = 0;
+			filter.wipe();
+			epoch = 1;
+		}
+	}
+
+private:
+	struct Slot{
+		State state;
+		unsigned int epoch;///<clear() that the slot was filled after, empty unless it is the table's epoch
+		PSNode * node;
+	};
+
+	typedef std::vector <Slot, PageAllocator <Slot> > SlotVector;
+
+	SlotVector slots;
+	std::size_t count;
+	int shift;///<64 - log2(slots.size())
+	unsigned int epoch;///<stamp of the occupied slots, never 0
+	BloomFilter filter;///<empty unless setFilter() turned it on
+
+	PSNode * probe(State state)const{
+		std::size_t mask = slots.size() - 1;
+		for(std::size_t i = slot(state); ; i = (i + 1) & mask){
+			if(slots[i].epoch != epoch)
+				return NULL;
+			if(slots[i].state == state)
+				return slots[i].node;
+		}
+	}
+
+	///@brief Home slot of a state, by Fibonacci hashing
+	std::size_t slot(State state)const{
+		return (std::size_t)(((unsigned long long)state * 0x9E3779B97F4A7C15ull) >> shift);
+	}
+
+	void place(PSNode * node){
+		std::size_t mask = slots.size() - 1;
+		std::size_t i = slot(node->state);
+		while(slots[i].epoch == epoch)
+			i = (i + 1) & mask;
+		slots[i].state = node->state;
+		slots[i].epoch = epoch;
+		slots[i].node = node;
+	}
+
+	void grow(){
+		SlotVector old(slots.get_allocator());
+		old.swap(slots);
+		Slot empty = {0, 0, NULL};
+		slots.assign(old.empty() ? 16 : 2 * old.size(), empty);
+		for(shift = 64; ((std::size_t)1 << (64 - shift)) < slots.size(); --shift)
+			;
+		for(std::size_t i = 0; i < old.size(); ++i){
+			if(old[i].epoch == epoch)
+				place(old[i].node);
+		}
+		if(!filter.empty())
+			rebuildFilter();
+	}
+
+	///@brief Size the filter for the slots and add every state in the table to it
+	void rebuildFilter(){
+		filter.resize(slots.size());
+		for(std::size_t i = 0; i < slots.size(); ++i){
+			if(slots[i].epoch == epoch)
+				filter.add(slots[i].state, epoch);
+		}
+	}
+};
+
+/**
+ * @brief Owns the problem space graph nodes of a search
+ *
+ * Nodes live in fixed size chunks that are never moved or freed until the arena
+ * is destroyed, so node pointers stay valid for the whole search and nothing
+ * leaks however a search ends. reset() takes every node back at once by
+ * rewinding to the first chunk, and the nodes are reinitialized in place when
+ * the next search allocates them.
+ */
+class NodeArena{
+public:
+	static const std::size_t CHUNK_SIZE = 1024;///<nodes per chunk without huge pages
+
+	NodeArena(){
+		chunk = 0;
+		used = 0;
+		count = 0;
+		policy = HUGE_PAGES_OFF;
+		chunkSize = CHUNK_SIZE;
+	}
+
+	///@brief Get a node initialized as by the PSNode constructor
+	PSNode * allocate(State newstate, PSNode * from, Move via, int estimate){
+		if(used == chunkSize){
+			++chunk;
+			used = 0;
+		}
+		if(chunk == chunks.size()){
+			chunks.push_back(Chunk(PageAllocator <PSNode>(policy)));
+			chunks.back().reserve(chunkSize);
+		}
+		Chunk &nodes = chunks[chunk];
+		PSNode * node;
+		if(used == nodes.size()){
+			//reserved, so this never moves the chunk's nodes
+			nodes.push_back(PSNode(newstate, from, via, estimate));
+			node = &nodes.back();
+		}else{
+			node = &nodes[used];
+			//hold on to the child list's memory across the reinitialization
+			std::vector <std::pair<Move, PSNode *> > children;
+			children.swap(node->children);
+			children.clear();
+			*node = PSNode(newstate, from, via, estimate);
+			node->children.swap(children);
+		}
+		++used;
+		++count;
+		return node;
+	}
+
+	///@brief Take back every node allocated since the last reset, in constant time
+	void reset(){
+		chunk = 0;
+		used = 0;
+		count = 0;
+	}
+
+	///@brief Choose whether chunks use huge pages, with chunks of a huge page each if they do
+	///@note Frees every chunk if that changes, so only call this right after reset()
+	void setHugePages(HugePages hugePages){
+		if(hugePages == policy)
+			return;
+		chunks.clear();
+		reset();
+		policy = hugePages;
+		chunkSize = CHUNK_SIZE;
+		if(policy != HUGE_PAGES_OFF and HUGE_PAGE_SIZE / sizeof(PSNode) > chunkSize)
+			chunkSize = HUGE_PAGE_SIZE / sizeof(PSNode);
+	}
+
+	///@brief Number of nodes allocated since the last reset
+	std::size_t size()const{
+		return count;
+	}
+
+private:
+	typedef std::vector <PSNode, PageAllocator <PSNode> > Chunk;
+
+	std::vector <Chunk> chunks;
+	std::size_t chunk;///<chunk the next node comes from
+	std::size_t used;///<nodes of that chunk already handed out since the last reset
+	std::size_t count;
+	HugePages policy;
+	std::size_t chunkSize;///<nodes per chunk
+
+	NodeArena(const NodeArena &);
+	NodeArena &operator=(const NodeArena &);
+};
+
+#endif
@@ -0,0 +1,121 @@
+/**
+ * @file driver.cpp
+ * @brief Runs a fuzz target without libFuzzer, for compilers that don't have it.
+ *
+ * Every file named on the command line, or in a directory named on it, is fed
+ * to LLVMFuzzerTestOneInput() once, which makes the seed corpus a regression
+ * test. With -runs=N the inputs are also mutated N times each by flipping,
+ * inserting, deleting and splicing bytes, a crude stand in for a real fuzzer
+ * that still finds shallow bugs under the sanitizers.
+ *
+ * usage: fuzz_target [-runs=N] [-seed=N] file or directory...
+ */
+
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <random>
+#include <string>
+#include <vector>
+
+using std::string;
+using std::vector;
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t * data, size_t size);
+
+static const std::size_t MAX_INPUT = 4096;
+
+static void run(const string &input){
+	//a copy of exactly the input's size, so the sanitizers catch reads past its end
+	vector <uint8_t> copy(input.begin(), input.end());
+	LLVMFuzzerTestOneInput(copy.data(), copy.size());
+}
+
+static void mutate(string &input, const vector <string> &inputs, std::mt19937 &random){
+	unsigned int edits = 1 + random() % 4;
+	for(unsigned int i = 0; i < edits; ++i){
+		std::size_t at = input.empty() ? 0 : random() % input.size();
+		switch(random() % 5){
+		case 0:
+			if(!input.empty())
+				input[at] = (char)(input[at] ^ (1 << (random() % 8)));
+			break;
+		case 1:
+			if(input.size() < MAX_INPUT)
+				input.insert(input.begin() + at, (char)random());
+			break;
+		case 2:
+			if(!input.empty())
+				input.erase(at, 1 + random() % 8);
+			break;
+		case 3:{
+			//bytes the parsers care about
+			static const char special[] = "[]|,-#\n \t\r";
+			if(input.size() < MAX_INPUT)
+				input.insert(input.begin() + at, special[random() % (sizeof(special) - 1)]);
+			break;
+		}
+		default:{
+			const string &other = inputs[random() % inputs.size()];
+			if(!other.empty() and input.size() < MAX_INPUT){
+				std::size_t from = random() % other.size();
+				input.insert(at, other, from, 1 + random() % 16);
+			}
+			break;
+		}
+		}
+	}
+	if(input.size() > MAX_INPUT)
+		input.resize(MAX_INPUT);
+}
+
+static bool readFile(const std::filesystem::path &path, vector <string> &inputs){
+	std::ifstream in(path, std::ios::binary);
+	if(!in)
+		return false;
+	inputs.push_back(string(std::istreambuf_iterator <char>(in), std::istreambuf_iterator <char>()));
+	return true;
+}
+
+int main(int argc, char * argv[]){
+	unsigned long runs = 0;
+	unsigned int seed = 1;
+	vector <string> inputs;
+	for(int i = 1; i < argc; ++i){
+		if(std::strncmp(argv[i], "-runs=", 6) == 0){
+			runs = std::strtoul(argv[i] + 6, NULL, 10);
+		}else if(std::strncmp(argv[i], "-seed=", 6) == 0){
+			seed = (unsigned int)std::strtoul(argv[i] + 6, NULL, 10);
+		}else if(std::filesystem::is_directory(argv[i])){
+			std::filesystem::directory_iterator entry(argv[i]), end;
+			for(; entry != end; ++entry){
+				if(entry->is_regular_file() and !readFile(entry->path(), inputs)){
+					std::cerr << "can't read " << entry->path() << std::endl;
+					return 1;
+				}
+			}
+		}else if(!readFile(argv[i], inputs)){
+			std::cerr << "can't read " << argv[i] << std::endl;
+			return 1;
+		}
+	}
+	if(inputs.empty())
+		inputs.push_back(string());
+
+	for(unsigned int i = 0; i < inputs.size(); ++i)
+		run(inputs[i]);
+
+	std::mt19937 random(seed);
+	for(unsigned long r = 0; r < runs; ++r){
+		string input = inputs[random() % inputs.size()];
+		mutate(input, inputs, random);
+		run(input);
+	}
+	std::cout << inputs.size() << " inputs, " << runs << " mutations" << std::endl;
+	return 0;
+}
@@ -0,0 +1,51 @@
+/**
+ * @file fuzz_puzzle.cpp
+ * @brief Fuzz target for puzzle definitions.
+ *
+ * Whatever Puzzle::load() accepts has to be a puzzle the rest of the solver can
+ * use: its default states must be legal and survive formatting and parsing, and
+ * small puzzles are solved outright.
+ */
+
+#include <cstdint>
+#include <cstdlib>
+#include <string>
+
+#include "solver.h"
+
+static const unsigned int SOLVE_MAX_ITEMS = 10;
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t * data, size_t size){
+	const char * text = (const char *)data;
+	Puzzle puzzle;
+	std::string error;
+	if(!puzzle.load(text, text + size, error)){
+		if(error.empty())
+			std::abort();
+		return 0;
+	}
+
+	if(puzzle.items.empty() or puzzle.items.size() > Puzzle::MAX_ITEMS or puzzle.capacity == 0)
+		std::abort();
+	if(!puzzle.legal(puzzle.start) or !puzzle.legal(puzzle.goal))
+		std::abort();
+	State states[2] = {puzzle.start, puzzle.goal};
+	for(int i = 0; i < 2; ++i){
+		std::string formatted = puzzle.toString(states[i]);
+		State parsed = 0;
+		if(formatted.size() > puzzle.textLength() or !puzzle.parse(formatted, parsed) or parsed != states[i])
+			std::abort();
+	}
+
+	if(puzzle.items.size() <= SOLVE_MAX_ITEMS){
+		SolverContext solver;
+		solver.options.algorithm = ALGORITHM_BFS;
+		SearchResult result = solver.solve(puzzle, puzzle.start, Goal(puzzle.goal, puzzle.all()));
+		State s = puzzle.start;
+		for(unsigned int i = 0; i < result.moves.size(); ++i)
+			s ^= result.moves[i].carried;
+		if(result.found and s != puzzle.goal)
+			std::abort();
+	}
+	return 0;
+}
@@ -0,0 +1,52 @@
+/**
+ * @file fuzz_query.cpp
+ * @brief Fuzz target for the batch query protocol.
+ *
+ * The first byte of the input picks the puzzle, the rest is a query line as
+ * read by fwdc --batch. Whatever parseQuery() accepts is solved the way the
+ * batch loop solves it, illegal states included.
+ */
+
+#include <cstdint>
+#include <cstdlib>
+#include <string>
+
+#include "solver.h"
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t * data, size_t size){
+	static const char menagerie[] =
+			"items Farmer Wolf Duck Corn Goat Cabbage\n"
+			"capacity 2\n"
+			"conflict Wolf Duck\nconflict Duck Corn\nconflict Wolf Goat\nconflict Goat Cabbage\n";
+	static Puzzle puzzles[2];
+	static bool loaded = false;
+	if(!loaded){
+		std::string error;
+		if(!puzzles[1].load(menagerie, menagerie + sizeof(menagerie) - 1, error))
+			std::abort();
+		loaded = true;
+	}
+	if(size == 0)
+		return 0;
+	const Puzzle &puzzle = puzzles[data[0] & 1];
+	const char * first = (const char *)data + 1;
+	const char * last = (const char *)data + size;
+
+	State start = 0;
+	Goal goal;
+	if(!parseQuery(puzzle, first, last, start, goal))
+		return 0;
+	if((start & ~puzzle.all()) != 0 or (goal.state & ~puzzle.all()) != 0 or goal.mask != puzzle.all())
+		std::abort();
+
+	SolverContext solver;
+	solver.options.algorithm = (data[0] & 2) ? ALGORITHM_BIDIRECTIONAL : ALGORITHM_ASTAR;
+	solver.options.frontier = FRONTIER_HEAP;
+	SearchResult result = solver.solve(puzzle, start, goal);
+	State s = start;
+	for(unsigned int i = 0; i < result.moves.size(); ++i)
+		s ^= result.moves[i].carried;
+	if(result.found and !goal.matches(s))
+		std::abort();
+	return 0;
+}
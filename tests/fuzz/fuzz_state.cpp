@@ -0,0 +1,57 @@
+/**
+ * @file fuzz_state.cpp
+ * @brief Fuzz target for the bracket notation parser.
+ *
+ * The input is parsed as a state of the classic puzzle and of a puzzle with
+ * long item names. Anything parseState() accepts must not read past the input
+ * and must format back to text that parses to the same state.
+ */
+
+#include <cstdint>
+#include <cstdlib>
+#include <vector>
+
+#include "puzzle.h"
+
+///@brief Parse with one name table and check the round trip
+static void roundTrip(const char * first, const char * last, const ItemNames &names){
+	unsigned long bits = 0;
+	std::from_chars_result r = parseState(first, last, bits, names);
+	if(r.ec != std::errc())
+		return;
+	if(r.ptr < first or r.ptr > last or bits >> names.count != 0)
+		std::abort();
+
+	std::vector <char> text(4096);
+	std::to_chars_result w = formatState(&text[0], &text[0] + text.size(), bits, names);
+	if(w.ec != std::errc())
+		std::abort();
+	unsigned long again = 0;
+	r = parseState(&text[0], w.ptr, again, names);
+	if(r.ec != std::errc() or r.ptr != w.ptr or again != bits)
+		std::abort();
+
+	//formatting into a buffer that is one byte short has to fail cleanly
+	std::size_t length = w.ptr - &text[0];
+	std::vector <char> shortBuffer(length - 1);
+	w = formatState(shortBuffer.data(), shortBuffer.data() + shortBuffer.size(), bits, names);
+	if(w.ec != std::errc::value_too_large)
+		std::abort();
+}
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t * data, size_t size){
+	const char * first = (const char *)data;
+	const char * last = first + size;
+
+	roundTrip(first, last, FWDCstate::names());
+	FWDCstate state;
+	std::from_chars_result r = FWDCstate::fromChars(first, last, state);
+	if(r.ec == std::errc() and (r.ptr < first or r.ptr > last))
+		std::abort();
+
+	static const char * const longNames[] = {"Farmer", "Wolf", "Duck", "Corn", "W", "Goose"};
+	static const unsigned char longLengths[] = {6, 4, 4, 4, 1, 5};
+	ItemNames names = {longNames, longLengths, 6, ','};
+	roundTrip(first, last, names);
+	return 0;
+}
@@ -0,0 +1,598 @@
+/**
+ * @file search_test.cpp
+ * @brief Property based and differential tests of the search strategies.
+ *
+ * Random puzzles, starts and goals are solved by every algorithm and frontier,
+ * and each answer is checked against a plain breadth first search over every
+ * state of the puzzle that shares no code with the solver: optimal strategies
+ * have to match its cost exactly, weighted A* has to stay within its bound, and
+ * every path is replayed move by move against the rules of the puzzle.
+ *
+ * usage: search_test [instances [seed]]
+ */
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "solver.h"
+
+using std::string;
+using std::vector;
+using std::cout;
+using std::endl;
+
+///@brief One way of running the searches
+struct Strategy{
+	const char * name;
+	Algorithm algorithm;
+	FrontierKind frontier;
+	unsigned int threads;
+	bool filter;///<see SearchOptions::filter
+	bool heuristics;///<every heuristic rather than the counting one alone, see SearchOptions::heuristics
+	bool small;///<only run on puzzles with few items, IDA* keeps no table of visited states
+};
+
+static const Strategy strategies[] = {
+	{"astar/multimap", ALGORITHM_ASTAR, FRONTIER_MULTIMAP, 1, false, false, false},
+	{"astar/heap", ALGORITHM_ASTAR, FRONTIER_HEAP, 1, false, false, false},
+	{"astar/bucket", ALGORITHM_ASTAR, FRONTIER_BUCKET, 1, false, false, false},
+	{"astar/heap+filter", ALGORITHM_ASTAR, FRONTIER_HEAP, 1, true, false, false},
+	{"weighted/multimap", ALGORITHM_WEIGHTED, FRONTIER_MULTIMAP, 1, false, false, false},
+	{"weighted/heap", ALGORITHM_WEIGHTED, FRONTIER_HEAP, 1, false, false, false},
+	{"weighted/bucket", ALGORITHM_WEIGHTED, FRONTIER_BUCKET, 1, false, false, false},
+	{"astar/heap+all-h", ALGORITHM_ASTAR, FRONTIER_HEAP, 1, false, true, false},
+	{"weighted/heap+all-h", ALGORITHM_WEIGHTED, FRONTIER_HEAP, 1, false, true, false},
+	{"lazy/multimap", ALGORITHM_LAZY, FRONTIER_MULTIMAP, 1, false, true, false},
+	{"lazy/heap", ALGORITHM_LAZY, FRONTIER_HEAP, 1, false, true, false},
+	{"lazy/bucket", ALGORITHM_LAZY, FRONTIER_BUCKET, 1, false, true, false},
+	{"epea/multimap", ALGORITHM_EPEA, FRONTIER_MULTIMAP, 1, false, false, false},
+	{"epea/heap", ALGORITHM_EPEA, FRONTIER_HEAP, 1, false, false, false},
+	{"epea/bucket", ALGORITHM_EPEA, FRONTIER_BUCKET, 1, false, false, false},
+	{"ida", ALGORITHM_IDA, FRONTIER_HEAP, 1, false, false, true},
+	{"bfs", ALGORITHM_BFS, FRONTIER_HEAP, 1, false, false, false},
+	{"bfs+filter", ALGORITHM_BFS, FRONTIER_HEAP, 1, true, false, false},
+	{"bidirectional", ALGORITHM_BIDIRECTIONAL, FRONTIER_HEAP, 1, false, false, false},
+	{"bidirectional+filter", ALGORITHM_BIDIRECTIONAL, FRONTIER_HEAP, 1, true, false, false},
+	{"parallel/1", ALGORITHM_PARALLEL, FRONTIER_HEAP, 1, false, false, false},
+	{"parallel/3", ALGORITHM_PARALLEL, FRONTIER_HEAP, 3, false, false, false},
+	{"parallel/3+filter", ALGORITHM_PARALLEL, FRONTIER_HEAP, 3, true, false, false},
+	{"bitmap", ALGORITHM_BITMAP, FRONTIER_HEAP, 1, false, false, false},
+	{"bdd", ALGORITHM_BDD, FRONTIER_HEAP, 1, false, false, false},
+	{"paths", ALGORITHM_PATHS, FRONTIER_HEAP, 1, false, false, false},
+	{"hierarchy", ALGORITHM_HIERARCHY, FRONTIER_HEAP, 1, false, false, false},
+	{"hierarchy/3", ALGORITHM_HIERARCHY, FRONTIER_HEAP, 3, false, false, false},
+	{"realtime", ALGORITHM_REALTIME, FRONTIER_HEAP, 1, false, false, false},
+	{"realtime+all-h", ALGORITHM_REALTIME, FRONTIER_BUCKET, 1, false, true, false},
+};
+static const unsigned int STRATEGY_COUNT = sizeof(strategies) / sizeof(strategies[0]);
+
+///@brief Set a context up to search the way a strategy does
+static void configure(SolverContext &solver, const Strategy &strategy){
+	solver.options.algorithm = strategy.algorithm;
+	solver.options.frontier = strategy.frontier;
+	solver.options.threads = strategy.threads;
+	solver.options.filter = strategy.filter;
+	solver.options.heuristics.assign(1, HEURISTIC_COUNTING);
+	if(strategy.heuristics){
+		solver.options.heuristics.push_back(HEURISTIC_CROSSINGS);
+		solver.options.heuristics.push_back(HEURISTIC_PATTERN);
+		solver.options.heuristics.push_back(HEURISTIC_LANDMARKS);
+	}
+}
+
+static const unsigned int IDA_MAX_ITEMS = 6;
+
+static int failures = 0;
+
+static void fail(const string &what){
+	++failures;
+	cout << "FAIL: " << what << endl;
+}
+
+static int bits(State s){
+	int rval = 0;
+	for(; s; s &= s - 1)
+		++rval;
+	return rval;
+}
+
+///@brief Is a state legal, checked pair by pair from the item names rather than with Puzzle::legal()
+static bool referenceLegal(const Puzzle &puzzle, State s){
+	bool farmerLeft = s & 1;
+	for(unsigned int i = 0; i < puzzle.conflicts.size(); ++i){
+		State pair = puzzle.conflicts[i];
+		bool bothLeft = (s & pair) == pair, bothRight = (s & pair) == 0;
+		if((bothLeft and !farmerLeft) or (bothRight and farmerLeft))
+			return false;
+	}
+	return true;
+}
+
+///@brief Can a move be made from a state, checked from first principles
+static bool referenceMove(const Puzzle &puzzle, State s, const Move &move, string &why){
+	bool farmerLeft = s & 1;
+	if(!(move.carried & 1)){
+		why = "the farmer is not in the boat";
+		return false;
+	}
+	if(move.toLeft == farmerLeft){
+		why = "the boat goes the wrong way";
+		return false;
+	}
+	if(move.carried & ~puzzle.all()){
+		why = "the boat carries items the puzzle doesn't have";
+		return false;
+	}
+	if((farmerLeft ? move.carried & ~s : move.carried & s) != 0){
+		why = "the boat carries items from the other bank";
+		return false;
+	}
+	if(bits(move.carried) > (int)puzzle.capacity + 1){
+		why = "the boat is overloaded";
+		return false;
+	}
+	if(!referenceLegal(puzzle, s ^ move.carried)){
+		why = "the move leaves a conflicting pair alone";
+		return false;
+	}
+	return true;
+}
+
+///@brief Cost of the cheapest path from start to goal by breadth first search over every state, -1 if none
+static int referenceCost(const Puzzle &puzzle, State start, const Goal &goal){
+	State all = puzzle.all();
+	vector <int> distance((std::size_t)all + 1, -1);
+	vector <State> queue(1, start);
+	distance[start] = 0;
+	for(std::size_t head = 0; head < queue.size(); ++head){
+		State s = queue[head];
+		if(goal.matches(s))
+			return distance[s];
+		//every subset of the farmer's bank that includes the farmer
+		State side = (s & 1) ? s : ~s & all;
+		State others = side & ~1u;
+		for(State load = others; ; load = (load - 1) & others){
+			Move move(load | 1, !(s & 1));
+			string why;
+			State t = s ^ move.carried;
+			if(distance[t] < 0 and referenceMove(puzzle, s, move, why)){
+				distance[t] = distance[s] + 1;
+				queue.push_back(t);
+			}
+			if(load == 0)
+				break;
+		}
+	}
+	return -1;
+}
+
+///@brief Replay a path against the rules and the goal
+static bool validPath(const Puzzle &puzzle, State start, const Goal &goal, const SearchResult &result, string &why){
+	State s = start;
+	int cost = 0;
+	for(unsigned int i = 0; i < result.moves.size(); ++i){
+		if(!referenceMove(puzzle, s, result.moves[i], why)){
+			std::ostringstream out;
+			out << "move " << i << " from " << puzzle.toString(s) << ": " << why;
+			why = out.str();
+			return false;
+		}
+		s ^= result.moves[i].carried;
+		cost += result.moves[i].cost();
+	}
+	if(!goal.matches(s)){
+		why = "path ends at " + puzzle.toString(s) + ", not the goal";
+		return false;
+	}
+	if(cost != result.cost){
+		why = "path cost differs from the reported cost";
+		return false;
+	}
+	return true;
+}
+
+///@brief Store a path as a PathCode, read its digits back and replay them
+static bool samePathCode(const Puzzle &puzzle, State start, const vector <Move> &moves, string &why){
+	PathCode code(puzzle), read(puzzle);
+	for(unsigned int i = 0; i < moves.size(); ++i){
+		if(!code.push(moves[i])){
+			why = "a boat load isn't in the path code's alphabet";
+			return false;
+		}
+	}
+	vector <Move> decoded;
+	if(!read.fromHex(code.steps, code.toHex())){
+		why = "path code " + code.toHex() + " doesn't read back";
+		return false;
+	}
+	if(!read.decode(puzzle, start, decoded) or decoded != moves){
+		why = "path code " + code.toHex() + " replays other moves";
+		return false;
+	}
+	return true;
+}
+
+///@brief Pick a random legal state
+static State randomLegal(const Puzzle &puzzle, std::mt19937 &random){
+	for(;;){
+		State s = (State)random() & puzzle.all();
+		if(puzzle.legal(s))
+			return s;
+	}
+}
+
+///@brief Make a random puzzle with up to maxItems items, farmer included
+static Puzzle randomPuzzle(std::mt19937 &random, unsigned int maxItems){
+	std::ostringstream text;
+	unsigned int count = 2 + random() % (maxItems - 1);
+	text << "items";
+	for(unsigned int i = 0; i < count; ++i)
+		text << ' ' << (char)('A' + i);
+	text << "\ncapacity " << 1 + random() % 3 << '\n';
+	unsigned int conflicts = count > 2 ? random() % (2 * count) : 0;
+	for(unsigned int i = 0; i < conflicts; ++i){
+		unsigned int a = 1 + random() % (count - 1), b = 1 + random() % (count - 1);
+		if(a != b)
+			text << "conflict " << (char)('A' + a) << ' ' << (char)('A' + b) << '\n';
+	}
+	Puzzle rval;
+	string error, definition = text.str();
+	if(!rval.load(definition.data(), definition.data() + definition.size(), error))
+		fail("random puzzle rejected: " + error + "\n" + definition);
+	return rval;
+}
+
+///@brief Check the generalized puzzle's rules against FWDCstate's hand written ones
+static void checkClassic(){
+	Puzzle puzzle;
+	vector <Move> moves;
+	for(unsigned int bits = 0; bits < 16; ++bits){
+		FWDCstate state = FWDCstate::unpack((unsigned char)bits);
+		vector <Move> expected = state.nextMoves();
+		if(!puzzle.legal(bits))
+			continue;
+		puzzle.nextMoves(bits, moves);
+		bool same = moves.size() == expected.size();
+		for(unsigned int i = 0; same and i < expected.size(); ++i)
+			same = std::find(moves.begin(), moves.end(), expected[i]) != moves.end();
+		if(!same)
+			fail("moves from " + state.toString() + " differ from FWDCstate");
+	}
+
+	//every strategy's answer to the classic puzzle, with each step checked by the canMove* rules
+	SolverContext solver;
+	for(unsigned int i = 0; i < STRATEGY_COUNT; ++i){
+		configure(solver, strategies[i]);
+		SearchResult result = solver.solve(puzzle, puzzle.start, Goal(puzzle.goal, puzzle.all()));
+		if(!result.found or result.cost != 7){
+			fail(string(strategies[i].name) + " does not solve the classic puzzle in 7 moves");
+			continue;
+		}
+		FWDCstate state = FWDCstate::unpack((unsigned char)puzzle.start);
+		for(unsigned int j = 0; j < result.moves.size(); ++j){
+			const Move &move = result.moves[j];
+			bool allowed = move.toLeft != state.FL and (move.carried == 1 ? state.canMoveF()
+					: move.carried == (1 | 2) ? state.canMoveFW()
+					: move.carried == (1 | 4) ? state.canMoveFD()
+					: move.carried == (1 | 8) ? state.canMoveFC() : false);
+			if(!allowed){
+				fail(string(strategies[i].name) + " makes a move canMove* forbids from " + state.toString());
+				break;
+			}
+			state = state.apply(move);
+		}
+		if(!state.isWinning())
+			fail(string(strategies[i].name) + " path for the classic puzzle doesn't win");
+	}
+}
+
+///@brief Declared invariants have to hold for every boat load, and give the parity of every path
+static void checkInvariants(unsigned int seed){
+	static const char classic[] = "items F W D C\ncapacity 1\nconflict W D\nconflict D C\n";
+	Puzzle puzzle;
+	string error, text = string(classic) + "invariant F\n";
+	if(!puzzle.load(text.data(), text.data() + text.size(), error) or puzzle.invariants.size() != 1)
+		fail("the farmer's invariant isn't taken: " + error);
+	text = string(classic) + "invariant W D\n";
+	if(puzzle.load(text.data(), text.data() + text.size(), error))
+		fail("an invariant some crossings keep is taken");
+
+	std::mt19937 random(seed);
+	for(unsigned int i = 0; i < 100; ++i){
+		puzzle = randomPuzzle(random, 10);
+		State start = randomLegal(puzzle, random);
+		Goal goal(randomLegal(puzzle, random), (State)random() & puzzle.all());
+		int parity = puzzle.pathParity(start, goal), cost = referenceCost(puzzle, start, goal);
+		if(cost >= 0 and (parity == Puzzle::PARITY_NEVER or (parity != Puzzle::PARITY_ANY and parity != (cost & 1)))){
+			std::ostringstream out;
+			out << "path parity " << parity << " from " << puzzle.toString(start) << " to " << puzzle.toString(goal.state)
+					<< " doesn't match a path of " << cost;
+			fail(out.str());
+			break;
+		}
+	}
+}
+
+///@brief Landmark tables saved to a file have to map back with the same bounds
+static void checkLandmarkFile(unsigned int seed){
+	static const char path[] = "search_test.landmarks";
+	std::mt19937 random(seed);
+	Puzzle puzzle = randomPuzzle(random, 10);
+	Goal goal(randomLegal(puzzle, random), puzzle.all());
+	LandmarkTable built, mapped;
+	std::remove(path);
+	if(!built.prepare(puzzle, path) or !mapped.prepare(puzzle, path) or !mapped.mapped()){
+		fail("landmark tables don't go through a file");
+		return;
+	}
+	built.target(goal);
+	mapped.target(goal);
+	for(State s = 0; s <= puzzle.all(); ++s){
+		if(built.h(s) != mapped.h(s)){
+			fail("mapped landmark tables differ from the ones saved");
+			break;
+		}
+	}
+	std::remove(path);
+
+	//a puzzle too large for tables, whose file claims a landmark but holds no table for it
+	Puzzle large;
+	string text = "items F", error;
+	for(unsigned int i = 1; i <= LandmarkTable::MAX_ITEMS; ++i)
+		text += " I" + std::to_string(i);
+	text += "\ncapacity 1\n";
+	if(!large.load(text.data(), text.data() + text.size(), error)){
+		fail("large puzzle doesn't load: " + error);
+		return;
+	}
+	std::uint32_t header[16] = {0x4C415746, 1, (std::uint32_t)large.items.size(), large.capacity, 0, 1, 0};
+	std::ofstream out(path, std::ios::binary | std::ios::trunc);
+	out.write((const char *)header, sizeof(header));
+	out.close();
+	LandmarkTable forged;
+	if(forged.load(path, large))
+		fail("landmark file with landmarks but no tables for a large puzzle is taken");
+	std::remove(path);
+}
+
+///@brief A contraction hierarchy saved to a file has to map back and find the same paths
+static void checkHierarchyFile(unsigned int seed){
+	static const char path[] = "search_test.hierarchy";
+	std::mt19937 random(seed);
+	Puzzle puzzle = randomPuzzle(random, 10);
+	ContractionHierarchy built, mapped;
+	std::remove(path);
+	if(!built.prepare(puzzle, path, 2) or !mapped.prepare(puzzle, path, 2) or !mapped.mapped()){
+		fail("contraction hierarchy doesn't go through a file");
+		return;
+	}
+	vector <Move> expected, found;
+	unsigned long settled = 0;
+	for(unsigned int i = 0; i < 100; ++i){
+		State start = randomLegal(puzzle, random), goal = randomLegal(puzzle, random);
+		bool reached = built.route(start, goal, expected, settled);
+		if(reached != mapped.route(start, goal, found, settled) or expected.size() != found.size()){
+			fail("mapped contraction hierarchy finds other paths than the one saved");
+			break;
+		}
+	}
+	std::remove(path);
+
+	//four states of one item, with an arc up from the first whose shortcut goes through that state again
+	Puzzle small;
+	string text = "items F A\ncapacity 1\n", error;
+	if(!small.load(text.data(), text.data() + text.size(), error)){
+		fail("small puzzle doesn't load: " + error);
+		return;
+	}
+	std::uint32_t words[] = {0x48435746, 2, (std::uint32_t)small.items.size(), small.capacity, 0, 4, 1,
+			0, 1, 2, 3, 0, 1, 2, 3, 0, 1, 1, 1, 1, 1, 2, 0};
+	std::ofstream out(path, std::ios::binary | std::ios::trunc);
+	out.write((const char *)words, sizeof(words));
+	out.close();
+	ContractionHierarchy forged;
+	if(forged.load(path, small))
+		fail("hierarchy file with a shortcut through a state no lower than its ends is taken");
+	std::remove(path);
+}
+
+///@brief Searches learning costs for a goal have to stay optimal as what they learn builds up
+///@note How many states they save is left to the benchmarks, ties on f can make any one search expand more.
+static void checkLearned(unsigned int seed){
+	std::mt19937 random(seed);
+	Puzzle puzzle = randomPuzzle(random, 10);
+	Goal goals[2] = {Goal(randomLegal(puzzle, random), puzzle.all()), Goal(randomLegal(puzzle, random), puzzle.all())};
+	SolverContext solver;
+	solver.options.frontier = FRONTIER_HEAP;
+	solver.options.heuristics.push_back(HEURISTIC_LEARNED);
+	SearchResult result;
+	for(unsigned int i = 0; i < 200; ++i){
+		//lazy A* for the last half, and the goal switching back and forth to forget what was learned
+		solver.options.algorithm = i < 100 ? ALGORITHM_ASTAR : ALGORITHM_LAZY;
+		const Goal &goal = goals[i / 25 % 2];
+		State start = randomLegal(puzzle, random);
+		int expected = referenceCost(puzzle, start, goal);
+		for(int pass = 0; pass < 2; ++pass){
+			solver.solve(puzzle, start, goal, result);
+			if(result.cost != expected){
+				std::ostringstream out;
+				out << "learned costs, seed " << seed << " query " << i << ": cost " << result.cost << ", optimal is " << expected;
+				fail(out.str());
+			}
+		}
+	}
+}
+
+///@brief Making the real-time moves one at a time has to reach the goal whenever it can be reached
+static void checkRealTimeMoves(unsigned int seed){
+	std::mt19937 random(seed);
+	Puzzle puzzle = randomPuzzle(random, 10);
+	Goal goal(randomLegal(puzzle, random), puzzle.all());
+	SolverContext solver;
+	solver.options.lookahead = 1;
+	for(unsigned int i = 0; i < 50; ++i){
+		State s = randomLegal(puzzle, random);
+		bool reachable = referenceCost(puzzle, s, goal) >= 0;
+		Move move;
+		string why;
+		while(solver.realTimeMove(puzzle, s, goal, move)){
+			if(!referenceMove(puzzle, s, move, why)){
+				fail("real-time move from " + puzzle.toString(s) + ": " + why);
+				return;
+			}
+			s ^= move.carried;
+		}
+		if(reachable != goal.matches(s)){
+			fail("real-time moves from " + puzzle.toString(s) + (reachable ? " stopped short of the goal" : " reached a goal that can't be"));
+			return;
+		}
+	}
+}
+
+///@brief A real-time search for a goal it can't reach has to give up without learning costs across the component
+///
+///B can't be left with any of the three others, which can't all cross it with
+///one seat in the boat, and eleven free items make the component large.
+static void checkRealTimeUnreachable(){
+	string text = "items F A B C D", error;
+	for(unsigned int i = 1; i <= 11; ++i)
+		text += " I" + std::to_string(i);
+	text += "\ncapacity 1\nconflict A B\nconflict B C\nconflict B D\n";
+	Puzzle puzzle;
+	if(!puzzle.load(text.data(), text.data() + text.size(), error)){
+		fail("unreachable puzzle doesn't load: " + error);
+		return;
+	}
+	SolverContext solver;
+	solver.options.algorithm = ALGORITHM_REALTIME;
+	SearchResult result;
+	solver.solve(puzzle, puzzle.all(), Goal(0, puzzle.all()), result);
+	if(result.found or result.expanded > 0)
+		fail("real-time search looked ahead towards a goal that can't be reached");
+}
+
+///@brief Path codes that are cut short, name loads the alphabet doesn't have or make an illegal crossing have to be turned down
+static void checkPathCodeErrors(){
+	Puzzle puzzle;
+	SearchResult result = search(puzzle, puzzle.start, Goal(puzzle.goal, puzzle.all()), SearchOptions());
+	PathCode code(puzzle);
+	for(unsigned int i = 0; i < result.moves.size(); ++i)
+		code.push(result.moves[i]);
+	string hex = code.toHex();
+	PathCode read(puzzle);
+	vector <Move> moves;
+	if(read.fromHex(code.steps, hex.substr(0, hex.size() - 2)) or read.fromHex(code.steps + 8, hex))
+		fail("path code of the wrong length is read");
+	if(read.fromHex(code.steps, "x" + hex.substr(1)))
+		fail("path code with a bad digit is read");
+	if(read.fromHex(code.steps - 1, hex))
+		fail("path code with bits set after its last step is read");
+
+	//three loads take two bits, leaving the index 3 for none of them
+	vector <State> loads(puzzle.loads.begin(), puzzle.loads.begin() + 3);
+	PathCode short3(loads);
+	if(!short3.fromHex(1, "03") or short3.decode(puzzle, puzzle.start, moves))
+		fail("path code naming a load beyond its alphabet replays");
+
+	//the farmer crossing alone at first leaves the duck with the wolf
+	PathCode alone(puzzle);
+	alone.push(Move(1, !(puzzle.start & 1)));
+	if(!read.fromHex(alone.steps, alone.toHex()) or read.decode(puzzle, puzzle.start, moves))
+		fail("path code with an illegal crossing replays");
+}
+
+///@brief Every heuristic has to stay at or below the true cost
+static void checkAdmissible(const Puzzle &puzzle, State start, const Goal &goal, int expected, const string &where){
+	static PatternDatabase patterns;
+	static LandmarkTable landmarks;
+	patterns.prepare(puzzle, goal);
+	landmarks.prepare(puzzle, "");
+	landmarks.target(goal);
+	int h[4] = {puzzle.h(start, goal), puzzle.crossings(start, goal), patterns.h(start), landmarks.h(start)};
+	for(int i = 0; i < 4; ++i){
+		if(h[i] > expected){
+			std::ostringstream out;
+			out << "heuristic " << i << " is " << h[i] << ", the cost is " << expected;
+			fail(where + out.str());
+		}
+	}
+}
+
+int main(int argc, char * argv[]){
+	unsigned int instances = argc > 1 ? (unsigned int)std::strtoul(argv[1], NULL, 10) : 1000;
+	unsigned int seed = argc > 2 ? (unsigned int)std::strtoul(argv[2], NULL, 10) : 2017;
+	std::mt19937 random(seed);
+
+	checkClassic();
+	checkInvariants(seed);
+	checkLandmarkFile(seed);
+	checkHierarchyFile(seed);
+	checkLearned(seed);
+	checkRealTimeMoves(seed);
+	checkRealTimeUnreachable();
+	checkPathCodeErrors();
+
+	//one context per strategy for the whole run, so reuse between searches is tested too
+	vector <SolverContext *> solvers;
+	for(unsigned int i = 0; i < STRATEGY_COUNT; ++i){
+		solvers.push_back(new SolverContext);
+		configure(*solvers[i], strategies[i]);
+		solvers[i]->options.weight = 1.5;
+	}
+
+	unsigned int solvable = 0;
+	SearchResult result;
+	for(unsigned int instance = 0; instance < instances and failures < 20; ++instance){
+		Puzzle puzzle = randomPuzzle(random, 10);
+		State start = randomLegal(puzzle, random);
+		Goal goal(randomLegal(puzzle, random), puzzle.all());
+		//every fourth goal only cares about some of the items
+		if(instance % 4 == 3)
+			goal.mask = (State)random() & puzzle.all();
+		int expected = referenceCost(puzzle, start, goal);
+		if(expected >= 0){
+			++solvable;
+			std::ostringstream where;
+			where << "seed " << seed << " instance " << instance << ": ";
+			checkAdmissible(puzzle, start, goal, expected, where.str());
+		}
+
+		for(unsigned int i = 0; i < STRATEGY_COUNT; ++i){
+			if(strategies[i].small and puzzle.items.size() > IDA_MAX_ITEMS)
+				continue;
+			solvers[i]->solve(puzzle, start, goal, result);
+			std::ostringstream where;
+			where << strategies[i].name << ", seed " << seed << " instance " << instance << ", "
+					<< puzzle.items.size() << " items capacity " << puzzle.capacity << ", "
+					<< puzzle.toString(start) << " to " << puzzle.toString(goal.state) << " mask " << goal.mask << ": ";
+			if(result.found != (expected >= 0)){
+				fail(where.str() + (expected >= 0 ? "missed a path" : "found a path that can't exist"));
+				continue;
+			}
+			if(!result.found)
+				continue;
+			string why;
+			if(!validPath(puzzle, start, goal, result, why) or !samePathCode(puzzle, start, result.moves, why))
+				fail(where.str() + why);
+			//the real-time search may wander on its way, but never finds a path shorter than the shortest
+			bool weighted = strategies[i].algorithm == ALGORITHM_WEIGHTED, realTime = strategies[i].algorithm == ALGORITHM_REALTIME;
+			if(realTime ? result.cost < expected : weighted ? result.cost < expected or result.cost > 1.5 * expected : result.cost != expected){
+				std::ostringstream out;
+				out << "cost " << result.cost << ", optimal is " << expected;
+				fail(where.str() + out.str());
+			}
+		}
+	}
+	for(unsigned int i = 0; i < solvers.size(); ++i)
+		delete solvers[i];
+
+	cout << instances << " instances, " << solvable << " solvable, " << failures << " failures" << endl;
+	return failures == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}